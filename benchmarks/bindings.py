@@ -0,0 +1,212 @@
+"""Benchmark suite for the pybiomes binding hot paths.
+
+Each case times a Python loop over one binding call and reports the cost
+per call in ns and the throughput in items/s (an item is one call, or one
+biome for gen_biomes). Results can be written as JSON and compared against
+an earlier run, or against raw_bench.c, which times the same cubiomes calls
+from C so the difference is the cost of the binding layer.
+
+Usage:
+    python benchmarks/bindings.py [--filter NAME] [--json out.json]
+                                  [--compare old.json] [--raw raw.json]
+
+    cc -O3 -o raw_bench benchmarks/raw_bench.c src/external/cubiomes/*.c -lm
+    ./raw_bench > raw.json
+"""
+import argparse
+import json
+import platform
+import sys
+import time
+
+import pybiomes
+from pybiomes import Finder, Generator, Rng, Xoroshiro
+from pybiomes.dimensions import DIM_OVERWORLD
+from pybiomes.structures import Village
+from pybiomes.versions import MC_1_21_1
+
+SEED = 1234567890
+SCALES = (1, 4, 16, 64, 256)
+AREA = 64
+
+
+def bench_apply_seed(n):
+    generator = Generator(MC_1_21_1, 0)
+    start = time.perf_counter_ns()
+    for seed in range(n):
+        generator.apply_seed(seed, DIM_OVERWORLD)
+    return time.perf_counter_ns() - start, n
+
+
+def make_get_biome_at(scale):
+    def bench(n):
+        generator = Generator(MC_1_21_1, 0)
+        generator.apply_seed(SEED, DIM_OVERWORLD)
+        start = time.perf_counter_ns()
+        for i in range(n):
+            generator.get_biome_at(scale, i & 255, 63 // scale, i >> 8)
+        return time.perf_counter_ns() - start, n
+    return bench
+
+
+def make_gen_biomes(scale):
+    def bench(n):
+        generator = Generator(MC_1_21_1, 0)
+        generator.apply_seed(SEED, DIM_OVERWORLD)
+        start = time.perf_counter_ns()
+        for i in range(n):
+            generator.gen_biomes(i * AREA, 63 // scale, 0, AREA, 1, AREA, scale)
+        return time.perf_counter_ns() - start, n * AREA * AREA
+    return bench
+
+
+def bench_get_structure_pos(n):
+    finder = Finder(MC_1_21_1)
+    start = time.perf_counter_ns()
+    for seed in range(n):
+        finder.get_structure_pos(Village, seed, 0, 0)
+    return time.perf_counter_ns() - start, n
+
+
+def bench_chunk_generate_rnd(n):
+    finder = Finder(MC_1_21_1)
+    start = time.perf_counter_ns()
+    for i in range(n):
+        finder.chunk_generate_rnd(SEED, i & 255, i >> 8)
+    return time.perf_counter_ns() - start, n
+
+
+def bench_is_viable_structure_pos(n):
+    generator = Generator(MC_1_21_1, 0)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    start = time.perf_counter_ns()
+    for i in range(n):
+        generator.is_viable_structure_pos(Village, (i & 63) << 9, (i >> 6) << 9, 0)
+    return time.perf_counter_ns() - start, n
+
+
+def bench_map_approx_height(n):
+    generator = Generator(MC_1_21_1, 0)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    surface_noise = pybiomes.SurfaceNoise()
+    surface_noise.init_surface_noise(DIM_OVERWORLD, SEED)
+    start = time.perf_counter_ns()
+    for i in range(n):
+        generator.map_approx_height(surface_noise, i * 16, 0, 16, 16)
+    return time.perf_counter_ns() - start, n * 16 * 16
+
+
+def bench_rng_next_int(n):
+    rng = Rng(SEED)
+    start = time.perf_counter_ns()
+    for _ in range(n):
+        rng.next_int(100)
+    return time.perf_counter_ns() - start, n
+
+
+def bench_xoroshiro_next_long(n):
+    xr = Xoroshiro()
+    xr.set_seed(SEED)
+    start = time.perf_counter_ns()
+    for _ in range(n):
+        xr.next_long()
+    return time.perf_counter_ns() - start, n
+
+
+def bench_stronghold_iteration(n):
+    finder = Finder(MC_1_21_1)
+    generator = Generator(MC_1_21_1, 0)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    start = time.perf_counter_ns()
+    for _ in range(n):
+        _, sh = finder.init_first_stronghold(SEED)
+        for _ in range(3):
+            _, sh = finder.next_stronghold(sh, generator)
+    return time.perf_counter_ns() - start, n * 3
+
+
+def bench_all_strongholds(n):
+    finder = Finder(MC_1_21_1)
+    generator = Generator(MC_1_21_1, 0)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    start = time.perf_counter_ns()
+    for _ in range(n):
+        finder.all_strongholds(generator, count=3)
+    return time.perf_counter_ns() - start, n * 3
+
+
+# name -> (function, calls per repeat). Names match raw_bench.c.
+CASES = {
+    'apply_seed': (bench_apply_seed, 2000),
+    **{f'get_biome_at_{s}': (make_get_biome_at(s), 2000) for s in (1, 4)},
+    **{f'gen_biomes_{s}': (make_gen_biomes(s), 20) for s in SCALES},
+    'get_structure_pos': (bench_get_structure_pos, 100000),
+    'chunk_generate_rnd': (bench_chunk_generate_rnd, 200000),
+    'is_viable_structure_pos': (bench_is_viable_structure_pos, 500),
+    'map_approx_height': (bench_map_approx_height, 50),
+    'rng_next_int': (bench_rng_next_int, 200000),
+    'xoroshiro_next_long': (bench_xoroshiro_next_long, 200000),
+    'stronghold_iteration': (bench_stronghold_iteration, 5),
+    'all_strongholds': (bench_all_strongholds, 5),
+}
+
+
+def run_case(fn, calls, repeats):
+    """Runs a case repeats times and keeps the fastest run.
+
+    Returns:
+        dict: ns per call, ns per item and items/s of the fastest run.
+    """
+    best = None
+    for _ in range(repeats):
+        elapsed, items = fn(calls)
+        if best is None or elapsed < best[0]:
+            best = (elapsed, items)
+    elapsed, items = best
+    return {
+        'calls': calls,
+        'items': items,
+        'ns_per_call': elapsed / calls,
+        'ns_per_item': elapsed / items,
+        'items_per_s': items * 1e9 / elapsed if elapsed else float('inf'),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--filter', default='', help='only run cases containing this text')
+    parser.add_argument('--repeats', type=int, default=5)
+    parser.add_argument('--scale', type=float, default=1.0, help='multiplies the calls per case')
+    parser.add_argument('--json', help='write the results to this file')
+    parser.add_argument('--compare', help='JSON from an earlier run to compare against')
+    parser.add_argument('--raw', help='JSON from raw_bench.c to report the binding overhead')
+    args = parser.parse_args()
+
+    baseline = json.load(open(args.compare))['results'] if args.compare else {}
+    raw = json.load(open(args.raw))['results'] if args.raw else {}
+
+    results = {}
+    print(f"{'case':<26} {'ns/call':>12} {'items/s':>14} {'vs C':>8} {'vs old':>8}")
+    for name, (fn, calls) in CASES.items():
+        if args.filter not in name:
+            continue
+        result = run_case(fn, max(1, int(calls * args.scale)), args.repeats)
+        if name in raw:
+            result['overhead_ns'] = result['ns_per_call'] - raw[name]['ns_per_call']
+        results[name] = result
+
+        vs_c = f"{result['ns_per_call'] / raw[name]['ns_per_call']:.2f}x" if name in raw else '-'
+        vs_old = f"{result['ns_per_call'] / baseline[name]['ns_per_call']:.2f}x" if name in baseline else '-'
+        print(f"{name:<26} {result['ns_per_call']:>12.0f} {result['items_per_s']:>14.0f} {vs_c:>8} {vs_old:>8}")
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump({
+                'python': sys.version.split()[0],
+                'platform': platform.platform(),
+                'results': results,
+            }, f, indent=2)
+
+
+if __name__ == '__main__':
+    main()
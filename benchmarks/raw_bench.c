@@ -0,0 +1,198 @@
+/*
+ * Times the cubiomes calls behind the cases in bindings.py directly from C,
+ * printing the results as JSON in the same format. Comparing the two runs
+ * gives the overhead of the binding layer.
+ *
+ *   cc -O3 -o raw_bench benchmarks/raw_bench.c src/external/cubiomes/[a-z]*.c -lm
+ *   ./raw_bench > raw.json
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/external/cubiomes/finders.h"
+#include "../src/external/cubiomes/generator.h"
+
+#define SEED 1234567890ULL
+#define AREA 64
+#define REPEATS 5
+
+static volatile uint64_t sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef uint64_t (*bench_fn)(int n, int arg);
+
+static uint64_t bench_apply_seed(int n, int arg) {
+    Generator g;
+    setupGenerator(&g, MC_1_21_1, 0);
+    for (int i = 0; i < n; i++) {
+        applySeed(&g, DIM_OVERWORLD, i);
+        sink += g.seed;
+    }
+    return n;
+}
+
+static uint64_t bench_get_biome_at(int n, int scale) {
+    Generator g;
+    setupGenerator(&g, MC_1_21_1, 0);
+    applySeed(&g, DIM_OVERWORLD, SEED);
+    for (int i = 0; i < n; i++) {
+        sink += getBiomeAt(&g, scale, i & 255, 63 / scale, i >> 8);
+    }
+    return n;
+}
+
+static uint64_t bench_gen_biomes(int n, int scale) {
+    Generator g;
+    setupGenerator(&g, MC_1_21_1, 0);
+    applySeed(&g, DIM_OVERWORLD, SEED);
+    for (int i = 0; i < n; i++) {
+        Range r = {scale, i * AREA, 0, AREA, AREA, 63 / scale, 1};
+        int *ids = allocCache(&g, r);
+        genBiomes(&g, ids, r);
+        sink += ids[0];
+        free(ids);
+    }
+    return (uint64_t)n * AREA * AREA;
+}
+
+static uint64_t bench_get_structure_pos(int n, int arg) {
+    Pos p;
+    for (int i = 0; i < n; i++) {
+        if (getStructurePos(Village, MC_1_21_1, i, 0, 0, &p)) {
+            sink += p.x;
+        }
+    }
+    return n;
+}
+
+static uint64_t bench_chunk_generate_rnd(int n, int arg) {
+    for (int i = 0; i < n; i++) {
+        sink += chunkGenerateRnd(SEED, i & 255, i >> 8);
+    }
+    return n;
+}
+
+static uint64_t bench_is_viable_structure_pos(int n, int arg) {
+    Generator g;
+    setupGenerator(&g, MC_1_21_1, 0);
+    applySeed(&g, DIM_OVERWORLD, SEED);
+    for (int i = 0; i < n; i++) {
+        sink += isViableStructurePos(Village, &g, (i & 63) << 9, (i >> 6) << 9, 0);
+    }
+    return n;
+}
+
+static uint64_t bench_map_approx_height(int n, int arg) {
+    Generator g;
+    SurfaceNoise sn;
+    float y[16*16];
+    int ids[16*16];
+    setupGenerator(&g, MC_1_21_1, 0);
+    applySeed(&g, DIM_OVERWORLD, SEED);
+    initSurfaceNoise(&sn, DIM_OVERWORLD, SEED);
+    for (int i = 0; i < n; i++) {
+        mapApproxHeight(y, ids, &g, &sn, i * 16, 0, 16, 16);
+        sink += ids[0];
+    }
+    return (uint64_t)n * 16 * 16;
+}
+
+static uint64_t bench_rng_next_int(int n, int arg) {
+    uint64_t seed = SEED;
+    for (int i = 0; i < n; i++) {
+        sink += nextInt(&seed, 100);
+    }
+    return n;
+}
+
+static uint64_t bench_xoroshiro_next_long(int n, int arg) {
+    Xoroshiro xr;
+    xSetSeed(&xr, SEED);
+    for (int i = 0; i < n; i++) {
+        sink += xNextLong(&xr);
+    }
+    return n;
+}
+
+static uint64_t bench_stronghold_iteration(int n, int arg) {
+    Generator g;
+    StrongholdIter sh;
+    setupGenerator(&g, MC_1_21_1, 0);
+    applySeed(&g, DIM_OVERWORLD, SEED);
+    for (int i = 0; i < n; i++) {
+        initFirstStronghold(&sh, MC_1_21_1, SEED);
+        for (int j = 0; j < 3; j++) {
+            nextStronghold(&sh, &g);
+        }
+        sink += sh.pos.x;
+    }
+    return (uint64_t)n * 3;
+}
+
+typedef struct {
+    const char *name;
+    bench_fn fn;
+    int arg;
+    int calls;
+} Case;
+
+// Same names and call counts as bindings.py.
+static const Case cases[] = {
+    {"apply_seed", bench_apply_seed, 0, 2000},
+    {"get_biome_at_1", bench_get_biome_at, 1, 2000},
+    {"get_biome_at_4", bench_get_biome_at, 4, 2000},
+    {"gen_biomes_1", bench_gen_biomes, 1, 20},
+    {"gen_biomes_4", bench_gen_biomes, 4, 20},
+    {"gen_biomes_16", bench_gen_biomes, 16, 20},
+    {"gen_biomes_64", bench_gen_biomes, 64, 20},
+    {"gen_biomes_256", bench_gen_biomes, 256, 20},
+    {"get_structure_pos", bench_get_structure_pos, 0, 100000},
+    {"chunk_generate_rnd", bench_chunk_generate_rnd, 0, 200000},
+    {"is_viable_structure_pos", bench_is_viable_structure_pos, 0, 500},
+    {"map_approx_height", bench_map_approx_height, 0, 50},
+    {"rng_next_int", bench_rng_next_int, 0, 200000},
+    {"xoroshiro_next_long", bench_xoroshiro_next_long, 0, 200000},
+    {"stronghold_iteration", bench_stronghold_iteration, 0, 5},
+};
+
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : "";
+    int count = (int)(sizeof(cases) / sizeof(cases[0]));
+    int first = 1;
+
+    printf("{\n  \"python\": null,\n  \"platform\": \"raw cubiomes\",\n  \"results\": {");
+    for (int i = 0; i < count; i++) {
+        const Case *c = &cases[i];
+        if (!strstr(c->name, filter)) {
+            continue;
+        }
+
+        uint64_t best = 0, items = 0;
+        for (int r = 0; r < REPEATS; r++) {
+            uint64_t start = now_ns();
+            items = c->fn(c->calls, c->arg);
+            uint64_t elapsed = now_ns() - start;
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        if (best == 0) {
+            best = 1;
+        }
+
+        printf("%s\n    \"%s\": {\"calls\": %d, \"items\": %llu, \"ns_per_call\": %.1f, "
+               "\"ns_per_item\": %.2f, \"items_per_s\": %.0f}",
+               first ? "" : ",", c->name, c->calls, (unsigned long long)items,
+               (double)best / c->calls, (double)best / items, items * 1e9 / best);
+        first = 0;
+    }
+    printf("\n  }\n}\n");
+    return 0;
+}
@@ -0,0 +1,73 @@
+"""Benchmark showing how seed checking scales across threads now that the
+Generator bindings release the GIL around cubiomes calls.
+
+Each worker thread owns its own Generator and checks a slice of the seeds by
+applying the seed and sampling a few biomes, which is the inner loop of most
+biome filters. The script reports seeds/s for an increasing number of threads
+along with the speedup over a single thread.
+
+Usage:
+    python benchmarks/thread_scaling.py [--seeds N] [--max-threads T]
+"""
+from concurrent.futures import ThreadPoolExecutor
+import argparse
+import os
+import time
+
+import pybiomes
+from pybiomes.versions import MC_1_21_1
+from pybiomes.dimensions import DIM_OVERWORLD
+
+
+POINTS = [(0, 63, 0), (-137, 63, -762), (512, 63, 512)]
+
+
+def check_seeds(seeds: range) -> int:
+    """Applies each seed and samples the biome at a few points.
+
+    Args:
+        seeds (range): The seeds to check.
+
+    Returns:
+        int: Number of seeds with plains at every point.
+    """
+    generator = pybiomes.Generator(MC_1_21_1, 0)
+    hits = 0
+    for seed in seeds:
+        generator.apply_seed(seed, DIM_OVERWORLD)
+        if all(generator.get_biome_at(1, x, y, z) == pybiomes.biomes.plains
+               for x, y, z in POINTS):
+            hits += 1
+    return hits
+
+
+def run(num_seeds: int, threads: int) -> float:
+    """Checks num_seeds seeds split evenly over the given number of threads.
+
+    Returns:
+        float: Elapsed wall time in seconds.
+    """
+    step = -(-num_seeds // threads)
+    chunks = [range(i, min(i + step, num_seeds)) for i in range(0, num_seeds, step)]
+    start = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=threads) as pool:
+        sum(pool.map(check_seeds, chunks))
+    return time.perf_counter() - start
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--seeds', type=int, default=20000)
+    parser.add_argument('--max-threads', type=int, default=os.cpu_count())
+    args = parser.parse_args()
+
+    thread_counts = sorted({1, 2, 4, 8, 16, 32, 64, args.max_threads})
+    thread_counts = [t for t in thread_counts if t <= args.max_threads]
+
+    baseline = None
+    print(f"{'threads':>8} {'seconds':>10} {'seeds/s':>12} {'speedup':>8}")
+    for threads in thread_counts:
+        elapsed = run(args.seeds, threads)
+        baseline = baseline or elapsed
+        print(f"{threads:>8} {elapsed:>10.3f} {args.seeds / elapsed:>12.0f} "
+              f"{baseline / elapsed:>8.2f}")
@@ -0,0 +1,31 @@
+"""Example script showing the village search from
+multiprocessing_village_search.py expressed as a pybiomes.Pipeline.
+
+The stages are declared once and run natively across all cores: the structure
+position and variant stages filter the 48-bit structure seeds, and only their
+survivors are expanded to full world seeds for the biome and viability
+checks. The pipeline orders the stages by cost and records how many seeds
+each one saw and passed.
+"""
+import time
+
+import pybiomes
+from pybiomes.structures import Village
+from pybiomes.versions import MC_1_19_2
+
+
+pipeline = pybiomes.Pipeline(MC_1_19_2)
+# Village at (16, -864), rotated COUNTERCLOCKWISE_90 with the
+# plains_fountain_1 starting piece.
+pipeline.add_structure(Village, 0, -2, box=(16, -864, 16, -864))
+pipeline.add_variant(Village, 0, -2, pybiomes.biomes.plains, rotation=3, start=1)
+pipeline.add_viable(Village, 16, -864)
+pipeline.add_biome(1, -137, 256, -762, pybiomes.biomes.plains)
+pipeline.add_biome(1, -117, 256, -777, pybiomes.biomes.meadow)
+pipeline.add_biome(1, -145, 256, -201, pybiomes.biomes.meadow)
+
+start = time.time()
+seeds = pipeline.run(0, 100000)
+print(f"Found {len(seeds)} world seeds in {time.time() - start:.2f} seconds")
+for stage in pipeline.stats:
+    print(f"{stage['stage']:>10}: {stage['passed']} / {stage['evaluated']}")
@@ -0,0 +1,24 @@
+"""Example script searching for quad witch hut bases with pybiomes.QuadSearch.
+
+The search runs natively across all cores over the candidates allowed by the
+'barely' low 20 bit constellations. Each hit is a 48-bit structure seed whose
+four huts in regions (0, 0) to (1, 1) fit in a 128 block radius, along with
+the hut positions. The search position is saved after each hit, so rerunning
+the script continues where the previous run stopped.
+"""
+import os
+
+import pybiomes
+from pybiomes.structures import Swamp_Hut
+from pybiomes.versions import MC_1_21_1
+
+STATE = 'quad_hut_search.pos'
+
+start = int(open(STATE).read()) if os.path.exists(STATE) else 0
+search = pybiomes.QuadSearch(MC_1_21_1, Swamp_Hut, start, low_bits='barely', radius=128)
+print(f"Searching candidates {start} to {search.hi}")
+
+for base, huts in search:
+    print(base, [(hut.x, hut.z) for hut in huts])
+    with open(STATE, 'w') as f:
+        f.write(str(search.position))
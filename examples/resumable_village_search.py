@@ -0,0 +1,26 @@
+"""Example script running the pipeline from pipeline_village_search.py as a
+resumable pybiomes.SearchJob.
+
+The job checks the whole 48-bit range a chunk at a time. Surviving world
+seeds are appended to village_seeds.txt and the position is checkpointed
+after every chunk, so stopping the script (or losing the machine) and
+running it again continues from the last completed chunk without repeating
+any output.
+"""
+import pybiomes
+from pybiomes.structures import Village
+from pybiomes.versions import MC_1_19_2
+
+
+pipeline = pybiomes.Pipeline(MC_1_19_2)
+pipeline.add_structure(Village, 0, -2, box=(16, -864, 16, -864))
+pipeline.add_variant(Village, 0, -2, pybiomes.biomes.plains, rotation=3, start=1)
+pipeline.add_viable(Village, 16, -864)
+pipeline.add_biome(1, -137, 256, -762, pybiomes.biomes.plains)
+
+job = pybiomes.SearchJob(pipeline, 0, 1 << 48, 'village_search.ckpt', 'village_seeds.txt', chunk=1 << 24)
+print(f"Resuming at {job.next} with {job.found} seeds found so far")
+
+while not job.done:
+    new = job.run(max_chunks=1)
+    print(f"{job.next / (1 << 48):.6%} done, {new} new seeds, {job.found} total")
@@ -0,0 +1,32 @@
+"""Example script showing the ruined portal search from
+ruined_portal_variants.py as two native calls.
+
+scan_structure_seeds finds the structure seeds with a portal attempt in the
+target chunk, and a pybiomes.RollProgram then replays the variant rolls on
+all of their chunk seeds at once, instead of building an Rng and rolling in
+Python for every candidate.
+"""
+import pybiomes
+from pybiomes.versions import MC_1_21_1
+
+finder = pybiomes.Finder(MC_1_21_1)
+
+# Min x/z block coordinates of the target chunk.
+x, z = -400, 48
+
+# Not underground, no air pocket, not giant, portal_1, rotated 90 degrees
+# clockwise and mirrored. The same caveats about biomes apply as in
+# ruined_portal_variants.py.
+program = pybiomes.RollProgram([
+    ('float', 0.5, 1.0),   # underground = nextFloat() < 0.5
+    ('float', 0.5, 1.0),   # airpocket = nextFloat() < 0.5
+    ('float', 0.05, 1.0),  # giant = nextFloat() < 0.05
+    ('int', 10, 0, 0),     # portal type = nextInt(10) + 1
+    ('int', 4, 1, 1),      # rotation = nextInt(4)
+    ('float', 0.0, 0.5),   # mirror = nextFloat() < 0.5
+])
+
+lower48s = finder.scan_structure_seeds(pybiomes.structures.Ruined_Portal, -1, 0,
+                                       0, 1000000, box=(x, z, x, z))
+for row in program.run(lower48s, x >> 4, z >> 4):
+    print(lower48s[row])
@@ -0,0 +1,67 @@
+#include <limits.h>
+#include <stdint.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+/*
+ * Argument helpers for the METH_FASTCALL hot methods, which receive their
+ * positional arguments as a C array rather than a tuple. Each converter
+ * accepts the same values as the PyArg_ParseTuple code it replaces, so
+ * switching a method over does not change its behaviour.
+ */
+
+#define FASTCALL(fn) ((PyCFunction)(void (*)(void))(fn))
+
+// Checks the number of positional arguments.
+static int fastcall_nargs(const char *name, Py_ssize_t nargs, Py_ssize_t expected) {
+    if (nargs == expected) {
+        return 0;
+    }
+    PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd argument%s (%zd given)",
+        name, expected, expected == 1 ? "" : "s", nargs);
+    return -1;
+}
+
+// Converts like the "i" format code.
+static inline int fastcall_int(PyObject *obj, int *out) {
+    long v = PyLong_AsLong(obj);
+    if (v == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (v > INT_MAX || v < INT_MIN) {
+        PyErr_SetString(PyExc_OverflowError, v > 0 ?
+            "signed integer is greater than maximum" : "signed integer is less than minimum");
+        return -1;
+    }
+    *out = (int)v;
+    return 0;
+}
+
+// Converts like the "I" format code: any int, taken modulo 2**32.
+static inline int fastcall_u32(PyObject *obj, uint32_t *out) {
+    if (PyFloat_Check(obj)) {
+        PyErr_SetString(PyExc_TypeError, "integer argument expected, got float");
+        return -1;
+    }
+    unsigned long v = PyLong_AsUnsignedLongMask(obj);
+    if (v == (unsigned long)-1 && PyErr_Occurred()) {
+        return -1;
+    }
+    *out = (uint32_t)v;
+    return 0;
+}
+
+// Converts like the "K" format code: any int, taken modulo 2**64.
+static inline int fastcall_u64(PyObject *obj, uint64_t *out) {
+    if (!PyLong_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "an integer is required (got type %.200s)", Py_TYPE(obj)->tp_name);
+        return -1;
+    }
+    unsigned long long v = PyLong_AsUnsignedLongLongMask(obj);
+    if (v == (unsigned long long)-1 && PyErr_Occurred()) {
+        return -1;
+    }
+    *out = v;
+    return 0;
+}
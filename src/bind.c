@@ -4,21 +4,41 @@
 #include <Python.h>
 
 #include "pybiomes.c"
+#include "buffers.c"
+#include "args.c"
+#include "threads.c"
+#include "noisecache.c"
+#include "render.c"
+#include "checks.c"
 
 #include "objects/range.c"
+#include "objects/array.c"
+#include "objects/biomearray.c"
 #include "objects/noise.c"
 #include "objects/biomenoise.c"
 #include "objects/generator.c"
 #include "objects/position.c"
 #include "objects/finder.c"
+#include "objects/stronghold.c"
 #include "objects/rng.c"
+#include "objects/rollprogram.c"
+#include "objects/pipeline.c"
+#include "objects/quadsearch.c"
+#include "objects/searchjob.c"
+#include "objects/tilecache.c"
 
 #include "modules/versions.c"
 #include "modules/dimensions.c"
 #include "modules/biomes.c"
 #include "modules/structures.c"
+#include "modules/climate.c"
 
 static PyMethodDef base_methods[] = {
+    {"set_num_threads", (PyCFunction) set_num_threads, METH_VARARGS, "Sets the number of threads batch methods use when passed threads=0; 0 means one per CPU"},
+    {"get_num_threads", (PyCFunction) get_num_threads, METH_NOARGS, "Returns the number of threads batch methods use when passed threads=0"},
+    {"set_noise_cache_size", (PyCFunction) set_noise_cache_size, METH_VARARGS, "Sets the byte budget of the cache of initialised noise states; 0 disables it"},
+    {"clear_noise_cache", (PyCFunction) clear_noise_cache, METH_NOARGS, "Empties the noise cache and resets its counters"},
+    {"noise_cache_info", (PyCFunction) noise_cache_info, METH_NOARGS, "Returns the noise cache hits, misses, evictions, entries, bytes and budget as a dict"},
     {NULL, NULL, 0, NULL}
 };
 
@@ -31,14 +51,31 @@ static struct PyModuleDef pybiomes = {
 };
 
 PyMODINIT_FUNC PyInit_pybiomes(void){
+    if (pool_init() < 0 || noise_cache_init() < 0) {
+        return NULL;
+    }
+    crc32_init();
+
     if (PyType_Ready(&GeneratorType) < 0) {
         return NULL;
     }
 
+    if (PyType_Ready(&HeightTilesType) < 0) {
+        return NULL;
+    }
+
     if (PyType_Ready(&RangeType) < 0) {
         return NULL;
     }
 
+    if (PyType_Ready(&ArrayType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&BiomeArrayType) < 0) {
+        return NULL;
+    }
+
     if (PyType_Ready(&FinderType) < 0) {
         return NULL;
     }
@@ -47,6 +84,10 @@ PyMODINIT_FUNC PyInit_pybiomes(void){
         return NULL;
     }
 
+    if (PyType_Ready(&StrongholdIteratorType) < 0) {
+        return NULL;
+    }
+
     if (PyType_Ready(&RngType) < 0) {
         return NULL;
     }
@@ -54,6 +95,26 @@ PyMODINIT_FUNC PyInit_pybiomes(void){
     if (PyType_Ready(&XoroshiroType) < 0) {
         return NULL;
     }
+
+    if (PyType_Ready(&PipelineType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&RollProgramType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&QuadSearchType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&SearchJobType) < 0) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&BiomeTileCacheType) < 0) {
+        return NULL;
+    }
     // Noise module objects
     if (PyType_Ready(&PerlinNoiseType) < 0) {
         return NULL;
@@ -76,6 +137,7 @@ PyMODINIT_FUNC PyInit_pybiomes(void){
     PyObject *dimensions = PyInit_dimensions(&pybiomes);
     PyObject *biomes = PyInit_biomes(&pybiomes);
     PyObject *structures = PyInit_structures(&pybiomes);
+    PyObject *climate = PyInit_climate(&pybiomes);
 
     PyObject *moduleDict = PyImport_GetModuleDict();
 
@@ -93,17 +155,33 @@ PyMODINIT_FUNC PyInit_pybiomes(void){
     PyDict_SetItemString(moduleDict, "pybiomes.biomes", biomes);
     PyModule_AddObject(base, "biomes", biomes);
 
+    Py_INCREF(climate);
+    PyDict_SetItemString(moduleDict, "pybiomes.climate", climate);
+    PyModule_AddObject(base, "climate", climate);
+
     Py_INCREF(&GeneratorType);
     PyModule_AddObject(base, "Generator", (PyObject *)&GeneratorType);
 
+    Py_INCREF(&HeightTilesType);
+    PyModule_AddObject(base, "HeightTiles", (PyObject *)&HeightTilesType);
+
     Py_INCREF(&RangeType);
     PyModule_AddObject(base, "Range", (PyObject *)&RangeType);
 
+    Py_INCREF(&ArrayType);
+    PyModule_AddObject(base, "Array", (PyObject *)&ArrayType);
+
+    Py_INCREF(&BiomeArrayType);
+    PyModule_AddObject(base, "BiomeArray", (PyObject *)&BiomeArrayType);
+
     Py_INCREF(&FinderType);
     PyModule_AddObject(base, "Finder", (PyObject *)&FinderType);
 
     Py_INCREF(&PosType);
     PyModule_AddObject(base, "Pos", (PyObject *)&PosType);
+
+    Py_INCREF(&StrongholdIteratorType);
+    PyModule_AddObject(base, "StrongholdIterator", (PyObject *)&StrongholdIteratorType);
 	
     Py_INCREF(&RngType);
     PyModule_AddObject(base, "Rng", (PyObject *)&RngType);
@@ -111,6 +189,21 @@ PyMODINIT_FUNC PyInit_pybiomes(void){
     Py_INCREF(&XoroshiroType);
     PyModule_AddObject(base, "Xoroshiro", (PyObject *)&XoroshiroType);
 	
+    Py_INCREF(&RollProgramType);
+    PyModule_AddObject(base, "RollProgram", (PyObject *)&RollProgramType);
+
+    Py_INCREF(&PipelineType);
+    PyModule_AddObject(base, "Pipeline", (PyObject *)&PipelineType);
+
+    Py_INCREF(&QuadSearchType);
+    PyModule_AddObject(base, "QuadSearch", (PyObject *)&QuadSearchType);
+
+    Py_INCREF(&SearchJobType);
+    PyModule_AddObject(base, "SearchJob", (PyObject *)&SearchJobType);
+
+    Py_INCREF(&BiomeTileCacheType);
+    PyModule_AddObject(base, "BiomeTileCache", (PyObject *)&BiomeTileCacheType);
+	
     Py_INCREF(&PerlinNoiseType);
     PyModule_AddObject(base, "PerlinNoise", (PyObject *)&PerlinNoiseType);
     
@@ -0,0 +1,121 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+/*
+ * Helpers for accepting caller-provided buffers (numpy arrays, array.array,
+ * memoryview, ...) in the bulk methods.
+ */
+
+// Returns the struct-module type code of a buffer format, skipping any
+// byte-order prefix. A missing format means unsigned bytes.
+static char buffer_type_code(const Py_buffer *view) {
+    const char *fmt = view->format;
+    if (!fmt) {
+        return 'B';
+    }
+    if (*fmt == '@' || *fmt == '=' || *fmt == '<' || *fmt == '>' || *fmt == '!') {
+        fmt++;
+    }
+    if (fmt[0] == '\0' || fmt[1] != '\0') {
+        return '\0';
+    }
+    return fmt[0];
+}
+
+static int buffer_is_int32(const Py_buffer *view) {
+    char code = buffer_type_code(view);
+    return view->itemsize == 4 && (code == 'i' || code == 'l');
+}
+
+static int buffer_is_int64(const Py_buffer *view) {
+    char code = buffer_type_code(view);
+    return view->itemsize == 8 && (code == 'q' || code == 'Q' || code == 'l' || code == 'L');
+}
+
+static int buffer_is_float32(const Py_buffer *view) {
+    return view->itemsize == 4 && buffer_type_code(view) == 'f';
+}
+
+static int buffer_is_float64(const Py_buffer *view) {
+    return view->itemsize == 8 && buffer_type_code(view) == 'd';
+}
+
+/*
+ * Acquires a C-contiguous int32 buffer from obj. Sets an exception and
+ * returns -1 if obj does not expose one.
+ */
+static int get_int32_buffer(PyObject *obj, Py_buffer *view, int writable) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+
+    if (PyObject_GetBuffer(obj, view, flags) < 0) {
+        return -1;
+    }
+
+    if (!buffer_is_int32(view)) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 32-bit ints");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Acquires a C-contiguous buffer of 64-bit ints, signed or unsigned, as used
+ * for seeds. Sets an exception and returns -1 if obj does not expose one.
+ */
+static int get_int64_buffer(PyObject *obj, Py_buffer *view, int writable) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+
+    if (PyObject_GetBuffer(obj, view, flags) < 0) {
+        return -1;
+    }
+
+    if (!buffer_is_int64(view)) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 64-bit ints");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Acquires a C-contiguous float32 buffer. Sets an exception and returns -1
+ * if obj does not expose one.
+ */
+static int get_float32_buffer(PyObject *obj, Py_buffer *view, int writable) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+
+    if (PyObject_GetBuffer(obj, view, flags) < 0) {
+        return -1;
+    }
+
+    if (!buffer_is_float32(view)) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 32-bit floats");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Acquires a C-contiguous float64 buffer, as used for noise coordinates.
+ * Sets an exception and returns -1 if obj does not expose one.
+ */
+static int get_float64_buffer(PyObject *obj, Py_buffer *view, int writable) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+
+    if (PyObject_GetBuffer(obj, view, flags) < 0) {
+        return -1;
+    }
+
+    if (!buffer_is_float64(view)) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 64-bit floats");
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "external/cubiomes/finders.h"
+
+/*
+ * World seed checks compiled from Python tuples, so the bulk search methods
+ * can evaluate them without calling back into Python:
+ *
+ *   ("viable", structure, x, z[, flags])  isViableStructurePos at block x, z
+ *   ("biome", scale, x, y, z, biome)      getBiomeAt equals biome
+ *   ("spawn", x, z, radius)               getSpawn within radius blocks of x, z
+ *   ("climate", param, x, z, lo, hi)      1.18+ climate noise at 1:4 x, z in [lo, hi]
+ */
+
+enum {
+    CHECK_VIABLE,
+    CHECK_BIOME,
+    CHECK_SPAWN,
+    CHECK_CLIMATE,
+};
+
+typedef struct {
+    int kind;
+    int structure;
+    uint32_t flags;
+    int scale;
+    int x, y, z;
+    int biome;
+    int radius;
+    int param;
+    double lo, hi;
+} SeedCheck;
+
+static int parse_seed_check(PyObject *item, SeedCheck *c) {
+    const char *kind;
+
+    if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) < 1 || !PyUnicode_Check(PyTuple_GET_ITEM(item, 0))) {
+        PyErr_SetString(PyExc_TypeError, "Each check must be a tuple starting with its kind ('viable', 'biome', 'spawn' or 'climate')");
+        return -1;
+    }
+
+    memset(c, 0, sizeof(*c));
+    kind = PyUnicode_AsUTF8(PyTuple_GET_ITEM(item, 0));
+    if (!kind) {
+        return -1;
+    }
+
+    if (strcmp(kind, "viable") == 0) {
+        c->kind = CHECK_VIABLE;
+        if (!PyArg_ParseTuple(item, "siii|I:viable check", &kind, &c->structure, &c->x, &c->z, &c->flags)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    if (strcmp(kind, "biome") == 0) {
+        c->kind = CHECK_BIOME;
+        if (!PyArg_ParseTuple(item, "siiiii:biome check", &kind, &c->scale, &c->x, &c->y, &c->z, &c->biome)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    if (strcmp(kind, "spawn") == 0) {
+        c->kind = CHECK_SPAWN;
+        if (!PyArg_ParseTuple(item, "siii:spawn check", &kind, &c->x, &c->z, &c->radius)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    if (strcmp(kind, "climate") == 0) {
+        c->kind = CHECK_CLIMATE;
+        if (!PyArg_ParseTuple(item, "siiidd:climate check", &kind, &c->param, &c->x, &c->z, &c->lo, &c->hi)) {
+            return -1;
+        }
+        if (c->param < 0 || c->param >= NP_MAX || c->param == NP_SHIFT) {
+            PyErr_SetString(PyExc_ValueError, "Climate check param must be one of the pybiomes.climate parameters");
+            return -1;
+        }
+        return 0;
+    }
+
+    PyErr_Format(PyExc_ValueError, "Unknown check kind '%s'", kind);
+    return -1;
+}
+
+/*
+ * Compiles a sequence of check tuples into a malloc'd array. Returns the
+ * number of checks, or -1 with an exception set.
+ */
+static Py_ssize_t parse_seed_checks(PyObject *seq, SeedCheck **checks) {
+    PyObject *fast = PySequence_Fast(seq, "checks must be a sequence of tuples");
+    if (!fast) {
+        return -1;
+    }
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+    *checks = (SeedCheck *)malloc((n ? n : 1) * sizeof(SeedCheck));
+    if (!*checks) {
+        Py_DECREF(fast);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (parse_seed_check(PySequence_Fast_GET_ITEM(fast, i), &(*checks)[i]) < 0) {
+            free(*checks);
+            *checks = NULL;
+            Py_DECREF(fast);
+            return -1;
+        }
+    }
+
+    Py_DECREF(fast);
+    return n;
+}
+
+// Tests a climate check against the noise of its parameter, sampled without
+// the coordinate shift like sampleClimatePara.
+static int climate_check_pass(const SeedCheck *c, const DoublePerlinNoise *noise) {
+    double v = sampleDoublePerlin(noise, c->x, 0, c->z);
+    return v >= c->lo && v <= c->hi;
+}
+
+static int seed_check_pass(const SeedCheck *c, Generator *g) {
+    switch (c->kind) {
+        case CHECK_VIABLE:
+            return isViableStructurePos(c->structure, g, c->x, c->z, c->flags) != 0;
+        case CHECK_BIOME:
+            return getBiomeAt(g, c->scale, c->x, c->y, c->z) == c->biome;
+        case CHECK_SPAWN: {
+            Pos spawn = getSpawn(g);
+            int64_t dx = (int64_t)spawn.x - c->x;
+            int64_t dz = (int64_t)spawn.z - c->z;
+            return dx*dx + dz*dz <= (int64_t)c->radius * c->radius;
+        }
+        case CHECK_CLIMATE:
+            if (g->mc < MC_1_18 || g->dim != DIM_OVERWORLD) {
+                return 0;
+            }
+            return climate_check_pass(c, &g->bn.climate[c->param]);
+    }
+    return 0;
+}
+
+// Evaluates the checks in order against a seeded generator, stopping at the
+// first one that fails.
+static int seed_checks_pass(const SeedCheck *checks, Py_ssize_t n, Generator *g) {
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (!seed_check_pass(&checks[i], g)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Rough relative cost of a check on an already seeded generator, used to
+ * order checks before any have been measured. Voronoi sampling at scale 1
+ * costs more than the 1:4 noise, and getSpawn samples many biomes. A climate
+ * check is a single noise sample.
+ */
+static double seed_check_cost(const SeedCheck *c) {
+    switch (c->kind) {
+        case CHECK_VIABLE:
+            return 40.0;
+        case CHECK_BIOME:
+            return c->scale == 1 ? 15.0 : 10.0;
+        case CHECK_SPAWN:
+            return 2000.0;
+        case CHECK_CLIMATE:
+            return 2.0;
+    }
+    return 1.0;
+}
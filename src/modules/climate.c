@@ -0,0 +1,13 @@
+#include <Python.h>
+
+PyMODINIT_FUNC PyInit_climate(PyModuleDef *pybiomes) {
+    PyObject *mod = PyModule_Create(pybiomes);
+    
+    PyModule_AddIntMacro(mod, NP_TEMPERATURE);
+    PyModule_AddIntMacro(mod, NP_HUMIDITY);
+    PyModule_AddIntMacro(mod, NP_CONTINENTALNESS);
+    PyModule_AddIntMacro(mod, NP_EROSION);
+    PyModule_AddIntMacro(mod, NP_WEIRDNESS);
+    
+    return mod;
+}
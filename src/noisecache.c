@@ -0,0 +1,382 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "pythread.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "external/cubiomes/generator.h"
+
+/*
+ * Relocation of the self-pointers of copied noise states. A seeded
+ * Generator or SurfaceNoise points into itself (octave arrays, layer
+ * parents and noise, splines), so after a memcpy those fields are moved by
+ * the distance between the blocks. Only the known pointer fields are
+ * touched, and each only if it points into the source, so seeds, salts and
+ * noise values are never rewritten.
+ */
+
+// Returns p moved from the src block of size bytes to dst if it points into src.
+static void *rebased(const void *p, const void *src, size_t size, void *dst) {
+    uintptr_t a = (uintptr_t)p, lo = (uintptr_t)src;
+    return a >= lo && a - lo < size ? (char *)dst + (a - lo) : (void *)p;
+}
+
+#define REBASE(field, dst, src) ((field) = rebased((field), (src), sizeof(*(src)), (dst)))
+
+static void rebase_octave(OctaveNoise *o, const void *src, size_t size, void *dst) {
+    o->octaves = rebased(o->octaves, src, size, dst);
+}
+
+static void rebase_double_perlin(DoublePerlinNoise *n, const void *src, size_t size, void *dst) {
+    rebase_octave(&n->octA, src, size, dst);
+    rebase_octave(&n->octB, src, size, dst);
+}
+
+static void rebase_layer(Layer *l, const Generator *src, Generator *dst) {
+    REBASE(l->noise, dst, src);
+    REBASE(l->data, dst, src);
+    REBASE(l->p, dst, src);
+    REBASE(l->p2, dst, src);
+}
+
+// Fixes up dst after it was copied from src. Only the union member used by the version is moved.
+static void rebase_generator(Generator *dst, const Generator *src) {
+    size_t size = sizeof(Generator);
+
+    if (dst->mc >= MC_1_18) {
+        BiomeNoise *bn = &dst->bn;
+        for (int i = 0; i < NP_MAX; i++) {
+            rebase_double_perlin(&bn->climate[i], src, size, dst);
+        }
+        REBASE(bn->sp, dst, src);
+        for (int i = 0; i < bn->ss.len; i++) {
+            Spline *sp = &bn->ss.stack[i];
+            for (int j = 0; j < sp->len; j++) {
+                REBASE(sp->val[j], dst, src);
+            }
+        }
+    } else if (dst->mc <= MC_B1_7) {
+        for (int i = 0; i < (int)(sizeof(dst->bnb.climate) / sizeof(OctaveNoise)); i++) {
+            rebase_octave(&dst->bnb.climate[i], src, size, dst);
+        }
+    } else {
+        LayerStack *ls = &dst->ls;
+        for (int i = 0; i < (int)(sizeof(ls->layers) / sizeof(Layer)); i++) {
+            rebase_layer(&ls->layers[i], src, dst);
+        }
+        REBASE(ls->entry_1, dst, src);
+        REBASE(ls->entry_4, dst, src);
+        REBASE(ls->entry_16, dst, src);
+        REBASE(ls->entry_64, dst, src);
+        REBASE(ls->entry_256, dst, src);
+        for (int i = 0; i < (int)(sizeof(dst->xlayer) / sizeof(Layer)); i++) {
+            rebase_layer(&dst->xlayer[i], src, dst);
+        }
+        REBASE(dst->entry, dst, src);
+    }
+
+    rebase_double_perlin(&dst->nn.temperature, src, size, dst);
+    rebase_double_perlin(&dst->nn.humidity, src, size, dst);
+}
+
+static void rebase_surface_noise(SurfaceNoise *dst, const SurfaceNoise *src) {
+    size_t size = sizeof(SurfaceNoise);
+    rebase_octave(&dst->octmin, src, size, dst);
+    rebase_octave(&dst->octmax, src, size, dst);
+    rebase_octave(&dst->octmain, src, size, dst);
+    rebase_octave(&dst->octsurf, src, size, dst);
+    rebase_octave(&dst->octdepth, src, size, dst);
+}
+
+/*
+ * LRU cache of initialised noise states shared by the whole module, so
+ * revisiting a seed copies its noise instead of initialising it again.
+ * Entries are snapshots of a SurfaceNoise, keyed by (dim, seed), or of a
+ * seeded Generator, keyed by (version, flags, dim, seed). Copying a state
+ * in or out is a memcpy followed by noise_cache_rebase.
+ *
+ * The cache has its own lock and is used without the GIL. Entries are
+ * evicted least recently used first to stay within the byte budget, and a
+ * budget of 0 disables the cache.
+ */
+
+#define NOISE_CACHE_DEFAULT_BUDGET (32u << 20)
+
+enum { NOISE_CACHE_SURFACE, NOISE_CACHE_GENERATOR };
+
+typedef struct {
+    int kind;
+    int mc;
+    uint32_t flags;
+    int dim;
+    uint64_t seed;
+} NoiseKey;
+
+typedef struct NoiseCacheEntry {
+    NoiseKey key;
+    uint64_t hash;
+    struct NoiseCacheEntry *chain;  // next entry in the same bucket
+    struct NoiseCacheEntry *prev;   // more recently used
+    struct NoiseCacheEntry *next;   // less recently used
+    size_t size;
+    uint64_t data[];
+} NoiseCacheEntry;
+
+typedef struct {
+    PyThread_type_lock lock;
+    NoiseCacheEntry **buckets;
+    size_t bucket_count;            // power of two
+    NoiseCacheEntry *head, *tail;   // most and least recently used
+    size_t entries;
+    size_t bytes;
+    size_t budget;
+    unsigned long long hits, misses, evictions;
+} NoiseCache;
+
+static NoiseCache noise_cache = {.budget = NOISE_CACHE_DEFAULT_BUDGET};
+
+#ifndef _WIN32
+/*
+ * The lock is held across fork so a child never inherits the cache halfway
+ * through an update. Holders never wait on anything else, so this cannot
+ * deadlock the forking thread.
+ */
+static void noise_cache_before_fork(void) {
+    PyThread_acquire_lock(noise_cache.lock, WAIT_LOCK);
+}
+
+static void noise_cache_after_fork(void) {
+    PyThread_release_lock(noise_cache.lock);
+}
+#endif
+
+// Allocates the cache lock. Called once from module init, with the GIL.
+static int noise_cache_init(void) {
+    if (noise_cache.lock) {
+        return 0;
+    }
+    noise_cache.lock = PyThread_allocate_lock();
+    if (!noise_cache.lock) {
+        PyErr_NoMemory();
+        return -1;
+    }
+#ifndef _WIN32
+    if (pthread_atfork(noise_cache_before_fork, noise_cache_after_fork, noise_cache_after_fork) != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not register the noise cache fork handlers");
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+static uint64_t noise_key_hash(const NoiseKey *key) {
+    uint64_t h = key->seed;
+    h ^= ((uint64_t)key->kind << 56) ^ ((uint64_t)(uint32_t)key->mc << 40) ^ ((uint64_t)key->flags << 8) ^ (uint32_t)key->dim;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static int noise_key_equal(const NoiseKey *a, const NoiseKey *b) {
+    return a->kind == b->kind && a->mc == b->mc && a->flags == b->flags && a->dim == b->dim && a->seed == b->seed;
+}
+
+static void noise_cache_rebase(int kind, void *dst, const void *src) {
+    if (kind == NOISE_CACHE_SURFACE) {
+        rebase_surface_noise((SurfaceNoise *)dst, (const SurfaceNoise *)src);
+    } else {
+        rebase_generator((Generator *)dst, (const Generator *)src);
+    }
+}
+
+// The following helpers are called with the cache lock held.
+
+static NoiseCacheEntry *noise_cache_find(const NoiseKey *key, uint64_t hash) {
+    if (!noise_cache.bucket_count) {
+        return NULL;
+    }
+    NoiseCacheEntry *e = noise_cache.buckets[hash & (noise_cache.bucket_count - 1)];
+    while (e && !(e->hash == hash && noise_key_equal(&e->key, key))) {
+        e = e->chain;
+    }
+    return e;
+}
+
+static void noise_cache_unlink(NoiseCacheEntry *e) {
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        noise_cache.head = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        noise_cache.tail = e->prev;
+    }
+}
+
+static void noise_cache_push_front(NoiseCacheEntry *e) {
+    e->prev = NULL;
+    e->next = noise_cache.head;
+    if (noise_cache.head) {
+        noise_cache.head->prev = e;
+    } else {
+        noise_cache.tail = e;
+    }
+    noise_cache.head = e;
+}
+
+static void noise_cache_remove(NoiseCacheEntry *e) {
+    NoiseCacheEntry **slot = &noise_cache.buckets[e->hash & (noise_cache.bucket_count - 1)];
+    while (*slot != e) {
+        slot = &(*slot)->chain;
+    }
+    *slot = e->chain;
+    noise_cache_unlink(e);
+    noise_cache.entries--;
+    noise_cache.bytes -= e->size;
+    free(e);
+}
+
+// Evicts least recently used entries until `extra` more bytes fit.
+static void noise_cache_trim(size_t extra) {
+    while (noise_cache.tail && noise_cache.bytes + extra > noise_cache.budget) {
+        noise_cache_remove(noise_cache.tail);
+        noise_cache.evictions++;
+    }
+}
+
+// Keeps about one bucket per entry. Returns -1 if the table cannot grow.
+static int noise_cache_reserve(void) {
+    if (noise_cache.entries < noise_cache.bucket_count) {
+        return 0;
+    }
+    size_t count = noise_cache.bucket_count ? 2 * noise_cache.bucket_count : 64;
+    NoiseCacheEntry **buckets = (NoiseCacheEntry **)calloc(count, sizeof(NoiseCacheEntry *));
+    if (!buckets) {
+        return -1;
+    }
+    for (NoiseCacheEntry *e = noise_cache.head; e; e = e->next) {
+        NoiseCacheEntry **slot = &buckets[e->hash & (count - 1)];
+        e->chain = *slot;
+        *slot = e;
+    }
+    free(noise_cache.buckets);
+    noise_cache.buckets = buckets;
+    noise_cache.bucket_count = count;
+    return 0;
+}
+
+/*
+ * Copies the cached state for key into dst. Returns 1 on a hit and 0 on a
+ * miss, including when the cache is disabled.
+ */
+static int noise_cache_get(const NoiseKey *key, void *dst, size_t size) {
+    uint64_t hash = noise_key_hash(key);
+    int hit = 0;
+
+    PyThread_acquire_lock(noise_cache.lock, WAIT_LOCK);
+    if (noise_cache.budget) {
+        NoiseCacheEntry *e = noise_cache_find(key, hash);
+        if (e && e->size == size) {
+            memcpy(dst, e->data, size);
+            noise_cache_rebase(key->kind, dst, e->data);
+            noise_cache_unlink(e);
+            noise_cache_push_front(e);
+            hit = 1;
+            noise_cache.hits++;
+        } else {
+            noise_cache.misses++;
+        }
+    }
+    PyThread_release_lock(noise_cache.lock);
+    return hit;
+}
+
+/*
+ * Stores a copy of src under key. States that do not fit the budget, and
+ * any that fail to allocate, are simply not cached.
+ */
+static void noise_cache_put(const NoiseKey *key, const void *src, size_t size) {
+    uint64_t hash = noise_key_hash(key);
+
+    PyThread_acquire_lock(noise_cache.lock, WAIT_LOCK);
+    if (size <= noise_cache.budget && !noise_cache_find(key, hash)) {
+        noise_cache_trim(size);
+        NoiseCacheEntry *e = (NoiseCacheEntry *)malloc(sizeof(NoiseCacheEntry) + size);
+        if (e && noise_cache_reserve() == 0) {
+            e->key = *key;
+            e->hash = hash;
+            e->size = size;
+            memcpy(e->data, src, size);
+            noise_cache_rebase(key->kind, e->data, src);
+
+            NoiseCacheEntry **slot = &noise_cache.buckets[hash & (noise_cache.bucket_count - 1)];
+            e->chain = *slot;
+            *slot = e;
+            noise_cache_push_front(e);
+            noise_cache.entries++;
+            noise_cache.bytes += size;
+        } else {
+            free(e);
+        }
+    }
+    PyThread_release_lock(noise_cache.lock);
+}
+
+static PyObject *set_noise_cache_size(PyObject *self, PyObject *args) {
+    Py_ssize_t budget;
+
+    if (!PyArg_ParseTuple(args, "n", &budget)) {
+        return NULL;
+    }
+    if (budget < 0) {
+        PyErr_SetString(PyExc_ValueError, "Cache size must not be negative");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(noise_cache.lock, WAIT_LOCK);
+    noise_cache.budget = (size_t)budget;
+    noise_cache_trim(0);
+    PyThread_release_lock(noise_cache.lock);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject *clear_noise_cache(PyObject *self, PyObject *Py_UNUSED(args)) {
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(noise_cache.lock, WAIT_LOCK);
+    while (noise_cache.head) {
+        noise_cache_remove(noise_cache.head);
+    }
+    noise_cache.hits = noise_cache.misses = noise_cache.evictions = 0;
+    PyThread_release_lock(noise_cache.lock);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject *noise_cache_info(PyObject *self, PyObject *Py_UNUSED(args)) {
+    unsigned long long hits, misses, evictions;
+    size_t entries, bytes, budget;
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(noise_cache.lock, WAIT_LOCK);
+    hits = noise_cache.hits;
+    misses = noise_cache.misses;
+    evictions = noise_cache.evictions;
+    entries = noise_cache.entries;
+    bytes = noise_cache.bytes;
+    budget = noise_cache.budget;
+    PyThread_release_lock(noise_cache.lock);
+    Py_END_ALLOW_THREADS
+
+    return Py_BuildValue("{sKsKsKsnsnsn}", "hits", hits, "misses", misses, "evictions", evictions,
+        "entries", (Py_ssize_t)entries, "bytes", (Py_ssize_t)bytes, "budget", (Py_ssize_t)budget);
+}
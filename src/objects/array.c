@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+/*
+ * Array is the packed result type of the bulk methods (seed lists,
+ * position lists, images, ...). It owns a malloc'd C-contiguous block of one
+ * to three dimensions and exposes it through the buffer protocol, so results
+ * can be handed to numpy or memoryview without per-item allocation.
+ */
+typedef struct {
+    PyObject_HEAD
+    char *data;
+    char format[2];
+    int ndim;
+    Py_ssize_t itemsize;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+} ArrayObject;
+
+extern PyTypeObject ArrayType;
+
+static void Array_dealloc(ArrayObject *self) {
+    free(self->data);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+/*
+ * Wraps a malloc'd block of rows x cols items of the given struct-module
+ * format ('i', 'Q', 'f', 'd', 'B', ...), taking ownership of data. cols == 0
+ * makes a one dimensional array of rows items.
+ */
+static ArrayObject *Array_from_data(void *data, char format, Py_ssize_t itemsize, Py_ssize_t rows, Py_ssize_t cols) {
+    ArrayObject *self = PyObject_New(ArrayObject, &ArrayType);
+    if (!self) {
+        free(data);
+        return NULL;
+    }
+
+    self->data = (char *)data;
+    self->format[0] = format;
+    self->format[1] = '\0';
+    self->itemsize = itemsize;
+    self->ndim = cols ? 2 : 1;
+    self->shape[0] = rows;
+    self->shape[1] = cols;
+    self->shape[2] = 0;
+    self->strides[0] = itemsize * (cols ? cols : 1);
+    self->strides[1] = itemsize;
+    self->strides[2] = 0;
+
+    return self;
+}
+
+// Wraps a malloc'd rows x cols x depth block, such as an RGB image.
+static ArrayObject *Array_from_data_3d(void *data, char format, Py_ssize_t itemsize, Py_ssize_t rows, Py_ssize_t cols, Py_ssize_t depth) {
+    ArrayObject *self = Array_from_data(data, format, itemsize, rows, cols);
+    if (!self) {
+        return NULL;
+    }
+
+    self->ndim = 3;
+    self->shape[2] = depth;
+    self->strides[0] = itemsize * cols * depth;
+    self->strides[1] = itemsize * depth;
+    self->strides[2] = itemsize;
+
+    return self;
+}
+
+// Allocates a zeroed array of rows x cols items.
+static ArrayObject *Array_zeros(char format, Py_ssize_t itemsize, Py_ssize_t rows, Py_ssize_t cols) {
+    size_t count = (size_t)rows * (cols ? cols : 1);
+    void *data = calloc(count ? count : 1, itemsize);
+    if (!data) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    return Array_from_data(data, format, itemsize, rows, cols);
+}
+
+static Py_ssize_t Array_size(ArrayObject *self) {
+    Py_ssize_t size = 1;
+    for (int i = 0; i < self->ndim; i++) {
+        size *= self->shape[i];
+    }
+    return size;
+}
+
+static PyObject *Array_box(ArrayObject *self, Py_ssize_t idx) {
+    const char *p = self->data + idx * self->itemsize;
+
+    switch (self->format[0]) {
+        case 'B': return PyLong_FromLong(*(const uint8_t *)p);
+        case 'i': return PyLong_FromLong(*(const int32_t *)p);
+        case 'q': return PyLong_FromLongLong(*(const int64_t *)p);
+        case 'Q': return PyLong_FromUnsignedLongLong(*(const uint64_t *)p);
+        case 'f': return PyFloat_FromDouble(*(const float *)p);
+        case 'd': return PyFloat_FromDouble(*(const double *)p);
+    }
+    PyErr_SetString(PyExc_TypeError, "Unsupported array format");
+    return NULL;
+}
+
+static int Array_getbuffer(ArrayObject *self, Py_buffer *view, int flags) {
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Array is read-only");
+        view->obj = NULL;
+        return -1;
+    }
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = Array_size(self) * self->itemsize;
+    view->readonly = 1;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+    view->ndim = (flags & PyBUF_ND) ? self->ndim : 1;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+}
+
+static PyBufferProcs Array_as_buffer = {
+    .bf_getbuffer = (getbufferproc) Array_getbuffer,
+    .bf_releasebuffer = NULL,
+};
+
+static Py_ssize_t Array_length(ArrayObject *self) {
+    return self->shape[0];
+}
+
+// Boxes n consecutive items from idx as a tuple.
+static PyObject *Array_tuple(ArrayObject *self, Py_ssize_t idx, Py_ssize_t n) {
+    PyObject *tuple = PyTuple_New(n);
+    if (!tuple) {
+        return NULL;
+    }
+    for (Py_ssize_t j = 0; j < n; j++) {
+        PyObject *item = Array_box(self, idx + j);
+        if (!item) {
+            Py_DECREF(tuple);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(tuple, j, item);
+    }
+    return tuple;
+}
+
+// Items of a one dimensional array, or rows as (nested) tuples otherwise.
+static PyObject *Array_item(ArrayObject *self, Py_ssize_t i) {
+    if (i < 0 || i >= self->shape[0]) {
+        PyErr_SetString(PyExc_IndexError, "Array index out of range");
+        return NULL;
+    }
+
+    if (self->ndim == 1) {
+        return Array_box(self, i);
+    }
+    if (self->ndim == 2) {
+        return Array_tuple(self, i * self->shape[1], self->shape[1]);
+    }
+
+    PyObject *row = PyTuple_New(self->shape[1]);
+    if (!row) {
+        return NULL;
+    }
+    for (Py_ssize_t j = 0; j < self->shape[1]; j++) {
+        PyObject *item = Array_tuple(self, (i * self->shape[1] + j) * self->shape[2], self->shape[2]);
+        if (!item) {
+            Py_DECREF(row);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(row, j, item);
+    }
+    return row;
+}
+
+static PySequenceMethods Array_as_sequence = {
+    .sq_length = (lenfunc) Array_length,
+    .sq_item = (ssizeargfunc) Array_item,
+};
+
+static PyObject *Array_tolist(ArrayObject *self, PyObject *Py_UNUSED(args)) {
+    PyObject *list = PyList_New(self->shape[0]);
+    if (!list) {
+        return NULL;
+    }
+
+    for (Py_ssize_t i = 0; i < self->shape[0]; i++) {
+        PyObject *item = Array_item(self, i);
+        if (!item) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+static PyObject *Array_get_shape(ArrayObject *self, void *closure) {
+    if (self->ndim == 1) {
+        return Py_BuildValue("(n)", self->shape[0]);
+    }
+    if (self->ndim == 2) {
+        return Py_BuildValue("(nn)", self->shape[0], self->shape[1]);
+    }
+    return Py_BuildValue("(nnn)", self->shape[0], self->shape[1], self->shape[2]);
+}
+
+static PyObject *Array_get_format(ArrayObject *self, void *closure) {
+    return PyUnicode_FromString(self->format);
+}
+
+static PyMethodDef Array_methods[] = {
+    {"tolist", (PyCFunction) Array_tolist, METH_NOARGS, "Returns the items as a list (rows as tuples, nested for three dimensions)"},
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef Array_getsets[] = {
+    {"shape", (getter)Array_get_shape, NULL, "Shape of the array", NULL},
+    {"format", (getter)Array_get_format, NULL, "struct module format of the items", NULL},
+    {NULL, 0, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyTypeObject ArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.Array",
+    .tp_doc = "Packed results of the bulk methods, exposed through the buffer protocol",
+    .tp_basicsize = sizeof(ArrayObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) Array_dealloc,
+    .tp_as_buffer = &Array_as_buffer,
+    .tp_as_sequence = &Array_as_sequence,
+    .tp_methods = Array_methods,
+    .tp_getset = Array_getsets,
+};
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdbool.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#include "../external/cubiomes/biomenoise.h"
+
+/*
+ * BiomeArray owns the int cache that cubiomes fills in genBiomes() and hands
+ * it out through the buffer protocol, so memoryview/numpy can read the biome
+ * ids without boxing every cell into a Python int.
+ *
+ * genBiomes() lays the cache out as [y][z][x]; the exported view has the
+ * shape (sx, sy, sz) and uses strides to map onto that layout.
+ */
+typedef struct {
+    PyObject_HEAD
+    int *data;
+    Range range;
+    Py_ssize_t len;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+} BiomeArrayObject;
+
+extern PyTypeObject BiomeArrayType;
+
+static void BiomeArray_dealloc(BiomeArrayObject *self) {
+    free(self->data);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+/* Takes ownership of data, which must have been allocated with malloc. */
+static BiomeArrayObject *BiomeArray_from_cache(int *data, Range r) {
+    BiomeArrayObject *self = PyObject_New(BiomeArrayObject, &BiomeArrayType);
+    if (!self) {
+        free(data);
+        return NULL;
+    }
+
+    int sy = r.sy > 0 ? r.sy : 1;
+
+    self->data = data;
+    self->range = r;
+    self->len = (Py_ssize_t)r.sx * sy * r.sz;
+
+    self->shape[0] = r.sx;
+    self->shape[1] = sy;
+    self->shape[2] = r.sz;
+
+    self->strides[0] = sizeof(int);
+    self->strides[1] = (Py_ssize_t)r.sx * r.sz * sizeof(int);
+    self->strides[2] = (Py_ssize_t)r.sx * sizeof(int);
+
+    return self;
+}
+
+// Whether the (sx, sy, sz) view is contiguous in C ('C') or Fortran ('F') order.
+static bool BiomeArray_contiguous(const BiomeArrayObject *self, char order) {
+    Py_ssize_t expected = sizeof(int);
+    for (int k = 0; k < 3; k++) {
+        int i = order == 'C' ? 2 - k : k;
+        if (self->shape[i] == 0) {
+            return true;
+        }
+        // Axes of length 1 are never stepped over, so their stride is free.
+        if (self->shape[i] > 1 && self->strides[i] != expected) {
+            return false;
+        }
+        expected *= self->shape[i];
+    }
+    return true;
+}
+
+static int BiomeArray_getbuffer(BiomeArrayObject *self, Py_buffer *view, int flags) {
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "BiomeArray is read-only");
+        view->obj = NULL;
+        return -1;
+    }
+
+    bool c_contiguous = BiomeArray_contiguous(self, 'C');
+    bool f_contiguous = BiomeArray_contiguous(self, 'F');
+    bool strided = (flags & PyBUF_STRIDES) == PyBUF_STRIDES;
+    bool contiguous = true;
+    if ((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS) {
+        contiguous = c_contiguous;
+    } else if ((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS) {
+        contiguous = f_contiguous;
+    } else if ((flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS) {
+        contiguous = c_contiguous || f_contiguous;
+    } else if ((flags & PyBUF_ND) == PyBUF_ND && !strided) {
+        // A shape without strides is read as C order.
+        contiguous = c_contiguous;
+    }
+    if (!contiguous) {
+        PyErr_SetString(PyExc_BufferError, "BiomeArray is laid out as [y][z][x]; request a strided buffer");
+        view->obj = NULL;
+        return -1;
+    }
+
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = self->len * sizeof(int);
+    view->readonly = 1;
+    view->itemsize = sizeof(int);
+    view->format = (flags & PyBUF_FORMAT) ? "i" : NULL;
+    view->ndim = 3;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    if (!view->shape) {
+        view->ndim = 1;
+    }
+
+    return 0;
+}
+
+static PyBufferProcs BiomeArray_as_buffer = {
+    .bf_getbuffer = (getbufferproc) BiomeArray_getbuffer,
+    .bf_releasebuffer = NULL,
+};
+
+// Flat indexing in cache order keeps gen_biomes() compatible with the list
+// it used to return.
+static Py_ssize_t BiomeArray_length(BiomeArrayObject *self) {
+    return self->len;
+}
+
+static PyObject *BiomeArray_item(BiomeArrayObject *self, Py_ssize_t i) {
+    if (i < 0 || i >= self->len) {
+        PyErr_SetString(PyExc_IndexError, "BiomeArray index out of range");
+        return NULL;
+    }
+    return PyLong_FromLong(self->data[i]);
+}
+
+static PySequenceMethods BiomeArray_as_sequence = {
+    .sq_length = (lenfunc) BiomeArray_length,
+    .sq_item = (ssizeargfunc) BiomeArray_item,
+};
+
+static PyObject *BiomeArray_get(BiomeArrayObject *self, PyObject *args) {
+    int i, j, k;
+
+    if (!PyArg_ParseTuple(args, "iii", &i, &j, &k)) {
+        return NULL;
+    }
+
+    if (i < 0 || i >= self->shape[0] || j < 0 || j >= self->shape[1] || k < 0 || k >= self->shape[2]) {
+        PyErr_SetString(PyExc_IndexError, "BiomeArray index out of range");
+        return NULL;
+    }
+
+    Py_ssize_t idx = (Py_ssize_t)j * self->shape[0] * self->shape[2] + (Py_ssize_t)k * self->shape[0] + i;
+    return PyLong_FromLong(self->data[idx]);
+}
+
+static PyObject *BiomeArray_tolist(BiomeArrayObject *self, PyObject *Py_UNUSED(args)) {
+    PyObject *list = PyList_New(self->len);
+    if (!list) {
+        return NULL;
+    }
+
+    for (Py_ssize_t i = 0; i < self->len; i++) {
+        PyObject *biome_py_obj = PyLong_FromLong(self->data[i]);
+        if (!biome_py_obj) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, biome_py_obj);
+    }
+    return list;
+}
+
+static PyObject *BiomeArray_get_shape(BiomeArrayObject *self, void *closure) {
+    return Py_BuildValue("(nnn)", self->shape[0], self->shape[1], self->shape[2]);
+}
+
+static PyObject *BiomeArray_get_range(BiomeArrayObject *self, void *closure) {
+    RangeObject *ret = (RangeObject *)Range_new(&RangeType, NULL, NULL);
+    if (!ret) {
+        return NULL;
+    }
+    ret->range = self->range;
+    return (PyObject *)ret;
+}
+
+static PyMethodDef BiomeArray_methods[] = {
+    {"get", (PyCFunction) BiomeArray_get, METH_VARARGS, "Gets the biome id at the cell (i, j, k) relative to the range origin"},
+    {"tolist", (PyCFunction) BiomeArray_tolist, METH_NOARGS, "Returns the biome ids as a flat list in cache order"},
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef BiomeArray_getsets[] = {
+    {"shape", (getter)BiomeArray_get_shape, NULL, "(sx, sy, sz)", NULL},
+    {"range", (getter)BiomeArray_get_range, NULL, "Range the biomes were generated for", NULL},
+    {NULL, 0, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyTypeObject BiomeArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.BiomeArray",
+    .tp_doc = "Biome ids produced by Generator.gen_biomes, exposed as an int32 buffer",
+    .tp_basicsize = sizeof(BiomeArrayObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) BiomeArray_dealloc,
+    .tp_as_buffer = &BiomeArray_as_buffer,
+    .tp_as_sequence = &BiomeArray_as_sequence,
+    .tp_methods = BiomeArray_methods,
+    .tp_getset = BiomeArray_getsets,
+};
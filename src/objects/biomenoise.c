@@ -6,6 +6,7 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include "structmember.h"
+#include "pythread.h"
 
 // Include the cubiomes header files directly
 #include "../external/cubiomes/noise.h"
@@ -20,18 +21,42 @@ extern PyTypeObject DoublePerlinNoiseType;
  * SurfaceNoise Object
  ******************************************************************************/
 
+/*
+ * The noise is written by init_surface_noise and read by the Generator
+ * height methods with the GIL released, so both sides hold the lock while
+ * they touch it.
+ */
 typedef struct {
     PyObject_HEAD
     SurfaceNoise noise;
+    PyThread_type_lock lock;
 } SurfaceNoiseObject;
 
+static PyObject *SurfaceNoise_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    SurfaceNoiseObject *self = (SurfaceNoiseObject *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->lock = PyThread_allocate_lock();
+        if (!self->lock) {
+            Py_DECREF(self);
+            return PyErr_NoMemory();
+        }
+    }
+    return (PyObject *) self;
+}
+
 static int SurfaceNoise_init(SurfaceNoiseObject *self, PyObject *args, PyObject *kwds) {
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(self->lock, WAIT_LOCK);
     self->noise = (SurfaceNoise){0};
+    PyThread_release_lock(self->lock);
+    Py_END_ALLOW_THREADS
     return 0;
 }
 
 static void SurfaceNoise_dealloc(SurfaceNoiseObject *self) {
-    PyObject_GC_UnTrack(self);
+    if (self->lock) {
+        PyThread_free_lock(self->lock);
+    }
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
@@ -43,6 +68,18 @@ static PyMemberDef SurfaceNoise_members[] = {
     {NULL}  /* Sentinel */
 };
 
+/*
+ * Initialises sn for (dim, seed), copying it from the noise cache when the
+ * seed was seen before. Safe to call without the GIL.
+ */
+static void surface_noise_cached(SurfaceNoise *sn, int dim, uint64_t seed) {
+    NoiseKey key = {NOISE_CACHE_SURFACE, 0, 0, dim, seed};
+    if (!noise_cache_get(&key, sn, sizeof(SurfaceNoise))) {
+        initSurfaceNoise(sn, dim, seed);
+        noise_cache_put(&key, sn, sizeof(SurfaceNoise));
+    }
+}
+
 /*
  * Wrapper function to initialize the SurfaceNoise struct.
  * This function is now a method of the SurfaceNoise object, so 'self'
@@ -56,12 +93,16 @@ static PyObject* SurfaceNoise_init_surface_noise(SurfaceNoiseObject *self, PyObj
         return NULL;
     }
 
-    initSurfaceNoise(&self->noise, dim, seed);
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(self->lock, WAIT_LOCK);
+    surface_noise_cached(&self->noise, dim, seed);
+    PyThread_release_lock(self->lock);
+    Py_END_ALLOW_THREADS
     Py_RETURN_NONE;
 }
 
 static PyMethodDef SurfaceNoise_methods[] = {
-    {"init_surface_noise", (PyCFunction)SurfaceNoise_init_surface_noise, METH_VARARGS, "Initializes a SurfaceNoise struct with a seed."},
+    {"init_surface_noise", (PyCFunction)SurfaceNoise_init_surface_noise, METH_VARARGS, "Initializes a SurfaceNoise struct with a seed, reusing the noise cache."},
     {NULL}  /* Sentinel */
 };
 
@@ -72,7 +113,7 @@ PyTypeObject SurfaceNoiseType = {
     .tp_basicsize = sizeof(SurfaceNoiseObject),
     .tp_itemsize = 0,
     .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
-    .tp_new = PyType_GenericNew,
+    .tp_new = SurfaceNoise_new,
     .tp_init = (initproc)SurfaceNoise_init,
     .tp_dealloc = (destructor)SurfaceNoise_dealloc,
     .tp_members = SurfaceNoise_members,
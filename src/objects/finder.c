@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <limits.h>
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
@@ -209,10 +210,11 @@ static PyObject *Finder_next_stronghold(FinderObject *self, PyObject *args) {
 	sh.mc = self->version;
 	
 	GeneratorObject *generator_obj = (GeneratorObject *)gen_obj;
-	Generator g = generator_obj->generator;
+	int valid;
 
-	
-	int valid = nextStronghold(&sh, &g);
+	GENERATOR_BEGIN_ALLOW_THREADS(generator_obj)
+	valid = nextStronghold(&sh, &generator_obj->generator);
+	GENERATOR_END_ALLOW_THREADS(generator_obj)
 	
     PosObject *posOut = Pos_new(&PosType, NULL, NULL);
     posOut->pos.x = sh.pos.x;
@@ -262,9 +264,11 @@ static PyObject *Finder_get_spawn(FinderObject *self, PyObject *args) {
     }
 	
 	GeneratorObject *generator_obj = (GeneratorObject *)gen_obj;
-	Generator g = generator_obj->generator;
-	
-    Pos spawn_pos = getSpawn(&g);
+    Pos spawn_pos;
+
+	GENERATOR_BEGIN_ALLOW_THREADS(generator_obj)
+    spawn_pos = getSpawn(&generator_obj->generator);
+	GENERATOR_END_ALLOW_THREADS(generator_obj)
     PosObject *ret = Pos_new(&PosType, NULL, NULL);
   
     ret->pos.x = spawn_pos.x;
@@ -272,24 +276,162 @@ static PyObject *Finder_get_spawn(FinderObject *self, PyObject *args) {
 	return (PyObject *)ret;
 }
 
+static PyObject *Finder_estimate_spawn(FinderObject *self, PyObject *args) {
+    PyObject *gen_obj;
+
+    if (!PyArg_ParseTuple(args, GENERATOR_OBJECT_TYPE, &GeneratorType, &gen_obj)) {
+        return NULL;
+    }
+
+    GeneratorObject *generator_obj = (GeneratorObject *)gen_obj;
+    Pos spawn_pos;
+
+    GENERATOR_BEGIN_ALLOW_THREADS(generator_obj)
+    spawn_pos = estimateSpawn(&generator_obj->generator, NULL);
+    GENERATOR_END_ALLOW_THREADS(generator_obj)
+
+    PosObject *ret = (PosObject *)Pos_new(&PosType, NULL, NULL);
+    if (!ret) {
+        return NULL;
+    }
+    ret->pos = spawn_pos;
+    return (PyObject *)ret;
+}
+
+typedef struct {
+    const uint64_t *seeds;
+    int dim;
+    int estimate;
+    int *out;               // (x, z) per seed
+} SpawnBatch;
+
+static void spawn_batch_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    SpawnBatch *sb = (SpawnBatch *)arg;
+    Generator *g = pool_generator(tid);
+
+    for (uint64_t i = lo; i < hi; i++) {
+        applySeed(g, sb->dim, sb->seeds[i]);
+        Pos p = sb->estimate ? estimateSpawn(g, NULL) : getSpawn(g);
+        sb->out[2*i] = p.x;
+        sb->out[2*i+1] = p.z;
+    }
+}
+
+static PyObject *Finder_get_spawns(FinderObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"generator", "seeds", "estimate", "threads", NULL};
+
+    PyObject *gen_obj, *seeds_obj;
+    int estimate = 0;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, GENERATOR_OBJECT_TYPE "O|$pi", kwlist, &GeneratorType, &gen_obj, &seeds_obj, &estimate, &threads)) {
+        return NULL;
+    }
+
+    Py_buffer seeds;
+    if (get_int64_buffer(seeds_obj, &seeds, 0) < 0) {
+        return NULL;
+    }
+
+    Py_ssize_t n = seeds.len / seeds.itemsize;
+    ArrayObject *ret = Array_zeros('i', sizeof(int), n, 2);
+    if (!ret) {
+        PyBuffer_Release(&seeds);
+        return NULL;
+    }
+
+    threads = resolve_thread_count(threads);
+    SpawnBatch sb;
+    sb.seeds = (const uint64_t *)seeds.buf;
+    sb.dim = DIM_OVERWORLD;
+    sb.estimate = estimate;
+    sb.out = (int *)ret->data;
+
+    GeneratorObject *generator_obj = (GeneratorObject *)gen_obj;
+    int mc, failed;
+    uint32_t flags;
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(generator_obj->lock, WAIT_LOCK);
+    mc = generator_obj->generator.mc;
+    flags = generator_obj->generator.flags;
+    PyThread_release_lock(generator_obj->lock);
+
+    // Every thread gets a pool generator with the same version and flags.
+    threads = pool_begin(threads);
+    failed = pool_generators(threads, mc, flags) < 0;
+    if (!failed) {
+        pool_run(0, n, 16, threads, spawn_batch_worker, &sb);
+    }
+    pool_end();
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&seeds);
+    if (failed) {
+        Py_DECREF(ret);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)ret;
+}
+
 
-static PyObject *Finder_chunk_generate_rnd(FinderObject *self, PyObject *args) {
+static PyObject *Finder_all_strongholds(FinderObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"generator", "count", NULL};
+
+    PyObject *gen_obj;
+    int count = 128;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, GENERATOR_OBJECT_TYPE "|i", kwlist, &GeneratorType, &gen_obj, &count)) {
+        return NULL;
+    }
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "count must be non-negative");
+        return NULL;
+    }
+
+    int *pos = (int *)malloc((count ? count : 1) * 2 * sizeof(int));
+    if (!pos) {
+        return PyErr_NoMemory();
+    }
+
+    GeneratorObject *generator_obj = (GeneratorObject *)gen_obj;
+    StrongholdIter sh;
+    int n = 0;
+
+    GENERATOR_BEGIN_ALLOW_THREADS(generator_obj)
+    initFirstStronghold(&sh, self->version, generator_obj->generator.seed);
+    while (n < count) {
+        int remaining = nextStronghold(&sh, &generator_obj->generator);
+        pos[2*n] = sh.pos.x;
+        pos[2*n+1] = sh.pos.z;
+        n++;
+        if (remaining <= 0) {
+            break;
+        }
+    }
+    GENERATOR_END_ALLOW_THREADS(generator_obj)
+
+    return (PyObject *)Array_from_data(pos, 'i', sizeof(int), n, 2);
+}
+
+static PyObject *Finder_chunk_generate_rnd(FinderObject *self, PyObject *const *args, Py_ssize_t nargs) {
     uint64_t seed;
-    int chunkX;
-	int chunkZ;
+    int chunkX, chunkZ;
 
-    if (!PyArg_ParseTuple(args, "Kii", &seed, &chunkX, &chunkZ)) {
+    if (fastcall_nargs("chunk_generate_rnd", nargs, 3) < 0 || fastcall_u64(args[0], &seed) < 0
+            || fastcall_int(args[1], &chunkX) < 0 || fastcall_int(args[2], &chunkZ) < 0) {
         return NULL;
     }
-	uint64_t rnd = chunkGenerateRnd(seed, chunkX, chunkZ);
+    uint64_t rnd = chunkGenerateRnd(seed, chunkX, chunkZ);
     return PyLong_FromLongLong(rnd);
 }
 
-static PyObject *Finder_get_structure_pos(FinderObject *self, PyObject *args) { 
+static PyObject *Finder_get_structure_pos(FinderObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int structure, reg_x, reg_z;
     uint64_t seed;
 
-    if (!PyArg_ParseTuple(args, "iKii", &structure, &seed, &reg_x, &reg_z)) {
+    if (fastcall_nargs("get_structure_pos", nargs, 4) < 0 || fastcall_int(args[0], &structure) < 0
+            || fastcall_u64(args[1], &seed) < 0 || fastcall_int(args[2], &reg_x) < 0 || fastcall_int(args[3], &reg_z) < 0) {
         return NULL;
     }
 
@@ -301,13 +443,99 @@ static PyObject *Finder_get_structure_pos(FinderObject *self, PyObject *args) {
     }
 
     PosObject *ret = Pos_new(&PosType, NULL, NULL);
-    
+    if (!ret) {
+        return NULL;
+    }
     ret->pos.x = p.x;
     ret->pos.z = p.z;
 
     return (PyObject *)ret;
 }
 
+typedef struct {
+    int structure;
+    int mc;
+    int reg_x, reg_z;
+    int x_min, z_min, x_max, z_max;
+    ResultBuf *results;
+} StructureScan;
+
+static void structure_scan_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    StructureScan *scan = (StructureScan *)arg;
+    ResultBuf *rb = &scan->results[tid];
+    Pos p;
+
+    for (uint64_t s = lo; s < hi; s++) {
+        if (!getStructurePos(scan->structure, scan->mc, s, scan->reg_x, scan->reg_z, &p)) {
+            continue;
+        }
+        if (p.x < scan->x_min || p.x > scan->x_max || p.z < scan->z_min || p.z > scan->z_max) {
+            continue;
+        }
+        resultbuf_push(rb, &s);
+    }
+}
+
+static PyObject *Finder_scan_structure_seeds(FinderObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"structure", "reg_x", "reg_z", "lo", "hi", "box", "threads", NULL};
+
+    StructureScan scan = {0};
+    uint64_t lo, hi;
+    int threads = 0;
+
+    scan.x_min = scan.z_min = INT_MIN;
+    scan.x_max = scan.z_max = INT_MAX;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "iiiKK|$(iiii)i", kwlist,
+            &scan.structure, &scan.reg_x, &scan.reg_z, &lo, &hi,
+            &scan.x_min, &scan.z_min, &scan.x_max, &scan.z_max, &threads)) {
+        return NULL;
+    }
+
+    if (lo > hi || hi > (1ULL << 48)) {
+        PyErr_SetString(PyExc_ValueError, "Seed range must satisfy 0 <= lo <= hi <= 2**48");
+        return NULL;
+    }
+
+    StructureConfig sc;
+    if (!getStructureConfig(scan.structure, self->version, &sc)) {
+        PyErr_SetString(PyExc_ValueError, "Structure is not supported by this version");
+        return NULL;
+    }
+
+    scan.mc = self->version;
+    threads = resolve_thread_count(threads);
+
+    scan.results = (ResultBuf *)malloc(threads * sizeof(ResultBuf));
+    if (!scan.results) {
+        return PyErr_NoMemory();
+    }
+    for (int i = 0; i < threads; i++) {
+        resultbuf_init(&scan.results[i], sizeof(uint64_t));
+    }
+
+    uint64_t *seeds;
+    size_t len;
+    int failed;
+
+    Py_BEGIN_ALLOW_THREADS
+    threads = parallel_range(lo, hi, 1 << 16, threads, structure_scan_worker, &scan);
+    seeds = (uint64_t *)resultbuf_merge(scan.results, threads, &len, &failed);
+    if (seeds) {
+        // Chunks finish out of order, so return the seeds sorted.
+        qsort(seeds, len, sizeof(uint64_t), compare_u64);
+    }
+    Py_END_ALLOW_THREADS
+
+    free(scan.results);
+
+    if (failed) {
+        free(seeds);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)Array_from_data(seeds, 'Q', sizeof(uint64_t), len, 0);
+}
+
 static PyObject *Finder_get_variant(FinderObject *self, PyObject *args) {
     int structType;
     unsigned long long seed;
@@ -354,6 +582,111 @@ static PyMemberDef Finder_members[] = {
     {NULL}  /* Sentinel */
 };
 
+typedef struct {
+    int structure;
+    int mc;
+    uint64_t seed;
+    int rx0, rz0;
+    int64_t nx;
+    int *pos;       // (x, z) per region
+    uint8_t *found; // whether the region has an attempt
+} RegionGrid;
+
+static void region_grid_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    RegionGrid *grid = (RegionGrid *)arg;
+    Pos p;
+
+    for (uint64_t i = lo; i < hi; i++) {
+        int rx = grid->rx0 + (int)(i % grid->nx);
+        int rz = grid->rz0 + (int)(i / grid->nx);
+        grid->found[i] = getStructurePos(grid->structure, grid->mc, grid->seed, rx, rz, &p) != 0;
+        grid->pos[2*i] = p.x;
+        grid->pos[2*i+1] = p.z;
+    }
+}
+
+/*
+ * All attempt positions in the regions rx0..rx1, rz0..rz1 (inclusive), in
+ * row order. With a generator, only positions passing isViableStructurePos
+ * are kept; that pass runs on the generator in place, under its lock.
+ */
+static PyObject *Finder_get_structure_positions(FinderObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"structure", "seed", "rx0", "rz0", "rx1", "rz1", "generator", "flags", "threads", NULL};
+
+    RegionGrid grid = {0};
+    int rx1, rz1;
+    PyObject *gen_obj = Py_None;
+    uint32_t flags = 0;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "iKiiii|$OIi", kwlist,
+            &grid.structure, &grid.seed, &grid.rx0, &grid.rz0, &rx1, &rz1, &gen_obj, &flags, &threads)) {
+        return NULL;
+    }
+
+    if (gen_obj != Py_None && !PyObject_TypeCheck(gen_obj, &GeneratorType)) {
+        PyErr_SetString(PyExc_TypeError, "generator must be a Generator");
+        return NULL;
+    }
+    if (rx1 < grid.rx0 || rz1 < grid.rz0) {
+        PyErr_SetString(PyExc_ValueError, "Region rectangle must satisfy rx0 <= rx1 and rz0 <= rz1");
+        return NULL;
+    }
+
+    StructureConfig sc;
+    if (!getStructureConfig(grid.structure, self->version, &sc)) {
+        PyErr_SetString(PyExc_ValueError, "Structure is not supported by this version");
+        return NULL;
+    }
+
+    grid.mc = self->version;
+    grid.nx = (int64_t)rx1 - grid.rx0 + 1;
+    int64_t total = grid.nx * ((int64_t)rz1 - grid.rz0 + 1);
+    if (total > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Region rectangle is too large");
+        return NULL;
+    }
+
+    grid.pos = (int *)malloc(total * 2 * sizeof(int));
+    grid.found = (uint8_t *)malloc(total);
+    if (!grid.pos || !grid.found) {
+        free(grid.pos);
+        free(grid.found);
+        return PyErr_NoMemory();
+    }
+
+    threads = resolve_thread_count(threads);
+    GeneratorObject *generator_obj = gen_obj != Py_None ? (GeneratorObject *)gen_obj : NULL;
+    int64_t n = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    parallel_range(0, total, 4096, threads, region_grid_worker, &grid);
+
+    if (generator_obj) {
+        PyThread_acquire_lock(generator_obj->lock, WAIT_LOCK);
+        Generator_materialize(generator_obj);
+        for (int64_t i = 0; i < total; i++) {
+            if (grid.found[i]) {
+                grid.found[i] = isViableStructurePos(grid.structure, &generator_obj->generator, grid.pos[2*i], grid.pos[2*i+1], flags) != 0;
+            }
+        }
+        PyThread_release_lock(generator_obj->lock);
+    }
+
+    // Compact the hits in place, keeping row order.
+    for (int64_t i = 0; i < total; i++) {
+        if (grid.found[i]) {
+            grid.pos[2*n] = grid.pos[2*i];
+            grid.pos[2*n+1] = grid.pos[2*i+1];
+            n++;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    free(grid.found);
+    return (PyObject *)Array_from_data(grid.pos, 'i', sizeof(int), n, 2);
+}
+
 static PyMethodDef Finder_methods[] = {
     {"set_attempt_seed", (PyCFunction)Finder_set_attempt_seed, METH_VARARGS, "Sets an attempt seed from a population seed and coordinates"},
     {"get_population_seed", (PyCFunction)Finder_get_population_seed, METH_VARARGS, "Generates a population seed from a world seed and coordinates."},
@@ -361,10 +694,15 @@ static PyMethodDef Finder_methods[] = {
     {"is_stronghold_biome", (PyCFunction)Finder_is_stronghold_biome, METH_VARARGS, "Checks if the biome is valid for stronghold placement"},
     {"init_first_stronghold", (PyCFunction)Finder_init_first_stronghold, METH_VARARGS, "Initialises first stronghold"},
     {"next_stronghold", (PyCFunction)Finder_next_stronghold, METH_VARARGS, "Finds next stronghold"},
+    {"all_strongholds", (PyCFunction)Finder_all_strongholds, METH_VARARGS | METH_KEYWORDS, "Finds the first count stronghold positions of a seeded Generator as an (N, 2) int32 array"},
     {"get_spawn", (PyCFunction)Finder_get_spawn, METH_VARARGS, "Gets world spawn position"},
-    {"chunk_generate_rnd", (PyCFunction)Finder_chunk_generate_rnd, METH_VARARGS, "Initialises and returns a random seed used in the chunk generation"},
-    {"get_structure_pos", (PyCFunction)Finder_get_structure_pos, METH_VARARGS, "Finds a structures position within the given region"},
+    {"estimate_spawn", (PyCFunction)Finder_estimate_spawn, METH_VARARGS, "Gets a cheaper approximation of the world spawn position"},
+    {"get_spawns", (PyCFunction)Finder_get_spawns, METH_VARARGS | METH_KEYWORDS, "Gets the spawn of many seeds as an (N, 2) int32 array, using the generator's version and flags and native threads"},
+    {"chunk_generate_rnd", FASTCALL(Finder_chunk_generate_rnd), METH_FASTCALL, "Initialises and returns a random seed used in the chunk generation"},
+    {"get_structure_pos", FASTCALL(Finder_get_structure_pos), METH_FASTCALL, "Finds a structures position within the given region"},
 	{"get_variant", (PyCFunction)Finder_get_variant, METH_VARARGS, "Gets a structures variant data (rotation, bounding box, etc.)"},
+    {"get_structure_positions", (PyCFunction)Finder_get_structure_positions, METH_VARARGS | METH_KEYWORDS, "Finds the attempt positions in regions rx0..rx1, rz0..rz1 as an (N, 2) int32 array, optionally keeping only those viable for generator"},
+    {"scan_structure_seeds", (PyCFunction)Finder_scan_structure_seeds, METH_VARARGS | METH_KEYWORDS, "Finds the 48-bit seeds in [lo, hi) whose structure attempt in the region lies in box, using native threads"},
     {NULL}  /* Sentinel */
 };
 
@@ -4,6 +4,7 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include "structmember.h"
+#include "pythread.h"
 
 #include "../external/cubiomes/biomenoise.h"
 #include "../external/cubiomes/generator.h"
@@ -11,15 +12,67 @@
 extern PyTypeObject SurfaceNoiseType;
 
 
+/*
+ * Climate noise of a lazily applied 1.18+ seed, initialised one parameter
+ * at a time. setClimateParaSeed always places the octaves at the start of
+ * BiomeNoise.oct, so each parameter is moved into its own slice of oct here.
+ */
+typedef struct {
+    DoublePerlinNoise climate[NP_MAX];
+    PerlinNoise oct[sizeof(((BiomeNoise *)0)->oct) / sizeof(PerlinNoise)];
+    int used;
+    uint32_t ready;
+} LazyClimate;
+
+static void rebase_lazy_climate(LazyClimate *dst, const LazyClimate *src) {
+    for (int i = 0; i < NP_MAX; i++) {
+        rebase_double_perlin(&dst->climate[i], src, sizeof(LazyClimate), dst);
+    }
+}
+
 typedef struct {
     PyObject_HEAD
     Generator generator;
+    PyThread_type_lock lock;
+    // Seed passed to apply_seed(lazy=True) that applySeed has not run for yet.
+    int pending;
+    int pending_dim;
+    uint64_t pending_seed;
+    LazyClimate *lazy;
 } GeneratorObject;
 
 extern PyTypeObject GeneratorType;
 
 #define GENERATOR_OBJECT_TYPE "O!"
 
+// Finishes a lazy apply_seed. Called with the generator lock held.
+static void Generator_materialize(GeneratorObject *self) {
+    if (self->pending) {
+        applySeed(&self->generator, self->pending_dim, self->pending_seed);
+        self->pending = 0;
+    }
+}
+
+/*
+ * Heavy cubiomes calls run with the GIL released. The per-object lock keeps
+ * threads that share one Generator from touching its state concurrently; it
+ * is only ever taken without the GIL held, so the two cannot deadlock.
+ *
+ * GENERATOR_BEGIN_ALLOW_THREADS also completes a lazily applied seed, while
+ * GENERATOR_BEGIN_RESEED is for calls that replace the seeded state anyway.
+ */
+#define GENERATOR_BEGIN_RESEED(obj) \
+    Py_BEGIN_ALLOW_THREADS \
+    PyThread_acquire_lock((obj)->lock, WAIT_LOCK);
+
+#define GENERATOR_BEGIN_ALLOW_THREADS(obj) \
+    GENERATOR_BEGIN_RESEED(obj) \
+    Generator_materialize(obj);
+
+#define GENERATOR_END_ALLOW_THREADS(obj) \
+    PyThread_release_lock((obj)->lock); \
+    Py_END_ALLOW_THREADS
+
 static int Generator_traverse(GeneratorObject *self, visitproc visit, void *arg) {
     return 0;
 }
@@ -31,6 +84,10 @@ static int Generator_clear(GeneratorObject *self) {
 static void Generator_dealloc(GeneratorObject *self) {
     PyObject_GC_UnTrack(self);
     Generator_clear(self);
+    if (self->lock) {
+        PyThread_free_lock(self->lock);
+    }
+    free(self->lazy);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
@@ -38,6 +95,12 @@ static PyObject *Generator_new(PyTypeObject *type, PyObject *args, PyObject *kwd
     GeneratorObject *self;
     self = (GeneratorObject *) type->tp_alloc(type, 0);
     if (self != NULL) {
+        self->lock = PyThread_allocate_lock();
+        if (!self->lock) {
+            Py_DECREF(self);
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate generator lock.");
+            return NULL;
+        }
         self->generator = (Generator){0};
         setupGenerator(&self->generator, MC_1_18, 0);
     }
@@ -54,8 +117,11 @@ static int Generator_init(GeneratorObject *self, PyObject *args, PyObject *kwds)
         return -1;
     }
 
+    GENERATOR_BEGIN_RESEED(self)
     self->generator = (Generator){0};
     setupGenerator(&self->generator, version, flags);
+    self->pending = 0;
+    GENERATOR_END_ALLOW_THREADS(self)
 
     return 0;
 }
@@ -64,30 +130,513 @@ static PyMemberDef Generator_members[] = {
     {NULL}  /* Sentinel */
 };
 
-static PyObject *Generator_apply_seed(GeneratorObject *self, PyObject *args) {
+// Applies a seed, copying the seeded state from the noise cache if it is there.
+static void apply_seed_cached(Generator *g, int dimension, uint64_t seed) {
+    NoiseKey key = {NOISE_CACHE_GENERATOR, g->mc, g->flags, dimension, seed};
+    if (!noise_cache_get(&key, g, sizeof(Generator))) {
+        applySeed(g, dimension, seed);
+        noise_cache_put(&key, g, sizeof(Generator));
+    }
+}
+
+// Applies a seed, or defers it with lazy. Returns 0, or -1 with an exception set.
+static int Generator_seed(GeneratorObject *self, uint64_t seed, int dimension, int lazy, int cache) {
+    // Only the 1.18+ Overworld has climate noise worth deferring.
+    if (lazy && (self->generator.mc < MC_1_18 || dimension != DIM_OVERWORLD)) {
+        lazy = 0;
+    }
+    if (lazy && !self->lazy) {
+        self->lazy = (LazyClimate *)malloc(sizeof(LazyClimate));
+        if (!self->lazy) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
+
+    GENERATOR_BEGIN_RESEED(self)
+    if (lazy) {
+        self->pending = 1;
+        self->pending_dim = dimension;
+        self->pending_seed = seed;
+        self->lazy->used = 0;
+        self->lazy->ready = 0;
+    } else {
+        self->pending = 0;
+        if (cache) {
+            apply_seed_cached(&self->generator, dimension, seed);
+        } else {
+            applySeed(&self->generator, dimension, seed);
+        }
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+    return 0;
+}
+
+static PyObject *Generator_apply_seed(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"seed", "dim", "lazy", "cache", NULL};
+
     uint64_t seed;
     int dimension;
+    int lazy = 0;
+    int cache = 0;
 
-    if (!PyArg_ParseTuple(args, "Ki", &seed, &dimension)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Ki|$pp", kwlist, &seed, &dimension, &lazy, &cache)) {
         return NULL;
     }
+    if (lazy && cache) {
+        PyErr_SetString(PyExc_ValueError, "lazy and cache cannot be combined");
+        return NULL;
+    }
+    if (Generator_seed(self, seed, dimension, lazy, cache) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+// Returns a new Generator with the same version, flags and seeded noise,
+// copied rather than initialised again. A lazily applied seed stays lazy.
+static PyObject *Generator_copy(GeneratorObject *self, PyObject *Py_UNUSED(args)) {
+    GeneratorObject *copy = (GeneratorObject *)Py_TYPE(self)->tp_alloc(Py_TYPE(self), 0);
+    if (!copy) {
+        return NULL;
+    }
+    copy->lock = PyThread_allocate_lock();
+    if (self->lazy) {
+        copy->lazy = (LazyClimate *)malloc(sizeof(LazyClimate));
+    }
+    if (!copy->lock || (self->lazy && !copy->lazy)) {
+        Py_DECREF(copy);
+        return PyErr_NoMemory();
+    }
 
-    applySeed(&self->generator, dimension, seed);
+    GENERATOR_BEGIN_RESEED(self)
+    memcpy(&copy->generator, &self->generator, sizeof(Generator));
+    rebase_generator(&copy->generator, &self->generator);
+    copy->pending = self->pending;
+    copy->pending_dim = self->pending_dim;
+    copy->pending_seed = self->pending_seed;
+    if (self->lazy) {
+        memcpy(copy->lazy, self->lazy, sizeof(LazyClimate));
+        rebase_lazy_climate(copy->lazy, self->lazy);
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    return (PyObject *)copy;
+}
+
+static PyObject *Generator_deepcopy(GeneratorObject *self, PyObject *memo) {
+    return Generator_copy(self, NULL);
+}
+
+// Pickles as Generator(version, flags) followed by __setstate__((seed, dim, lazy)).
+static PyObject *Generator_reduce(GeneratorObject *self, PyObject *Py_UNUSED(args)) {
+    int mc, dim, pending;
+    uint32_t flags;
+    uint64_t seed;
+
+    GENERATOR_BEGIN_RESEED(self)
+    mc = self->generator.mc;
+    flags = self->generator.flags;
+    pending = self->pending;
+    seed = pending ? self->pending_seed : self->generator.seed;
+    dim = pending ? self->pending_dim : self->generator.dim;
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    return Py_BuildValue("O(iI)(KiN)", (PyObject *)Py_TYPE(self), mc, flags,
+        (unsigned long long)seed, dim, PyBool_FromLong(pending));
+}
+
+static PyObject *Generator_setstate(GeneratorObject *self, PyObject *state) {
+    uint64_t seed;
+    int dimension;
+    int lazy = 0;
+
+    if (!PyArg_ParseTuple(state, "Ki|p:__setstate__", &seed, &dimension, &lazy)) {
+        return NULL;
+    }
+    // A generator that was never seeded has nothing more to restore.
+    if (dimension != DIM_UNDEF && Generator_seed(self, seed, dimension, lazy, 0) < 0) {
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
-static PyObject *Generator_get_biome_at(GeneratorObject *self, PyObject *args) {
+/*
+ * Returns the noise of a climate parameter, initialising just that
+ * parameter if the seed was applied lazily. Called with the lock held.
+ */
+static const DoublePerlinNoise *Generator_climate(GeneratorObject *self, int param) {
+    if (!self->pending) {
+        return &self->generator.bn.climate[param];
+    }
+
+    LazyClimate *lc = self->lazy;
+    if (!(lc->ready & (1u << param))) {
+        // The generator's own BiomeNoise is unused until the seed is
+        // materialised, so it serves as scratch space.
+        BiomeNoise *bn = &self->generator.bn;
+        setClimateParaSeed(bn, self->pending_seed, self->generator.flags & LARGE_BIOMES, param, -1);
+
+        const DoublePerlinNoise *src = &bn->climate[param];
+        int na = src->octA.octcnt, nb = src->octB.octcnt;
+        int cap = (int)(sizeof(lc->oct) / sizeof(PerlinNoise));
+        if (lc->used + na + nb > cap) {
+            Generator_materialize(self);
+            return &self->generator.bn.climate[param];
+        }
+
+        PerlinNoise *dst = lc->oct + lc->used;
+        memcpy(dst, src->octA.octaves, na * sizeof(PerlinNoise));
+        memcpy(dst + na, src->octB.octaves, nb * sizeof(PerlinNoise));
+        lc->climate[param] = *src;
+        lc->climate[param].octA.octaves = dst;
+        lc->climate[param].octB.octaves = dst + na;
+        lc->used += na + nb;
+        lc->ready |= 1u << param;
+    }
+    return &lc->climate[param];
+}
+
+// Validates a climate parameter for the climate sampling methods.
+static int Generator_check_climate_param(GeneratorObject *self, int param) {
+    if (param < 0 || param >= NP_MAX || param == NP_SHIFT) {
+        PyErr_SetString(PyExc_ValueError, "param must be one of the pybiomes.climate parameters");
+        return -1;
+    }
+    if (self->generator.mc < MC_1_18) {
+        PyErr_SetString(PyExc_ValueError, "Climate noise requires version 1.18 or later");
+        return -1;
+    }
+    return 0;
+}
+
+// Whether the applied seed has climate noise. Called with the lock held.
+static int Generator_has_climate(GeneratorObject *self) {
+    return self->pending || self->generator.dim == DIM_OVERWORLD;
+}
+
+static PyObject *Generator_no_climate(void) {
+    PyErr_SetString(PyExc_ValueError, "Climate noise requires an Overworld seed");
+    return NULL;
+}
+
+/*
+ * The climate methods sample at 1:4 coordinates without the coordinate
+ * shift, like sampleClimatePara, so they match the values climate filters
+ * in cubiomes work with.
+ */
+static PyObject *Generator_sample_climate(GeneratorObject *self, PyObject *args) {
+    int param;
+    double x, z;
+
+    if (!PyArg_ParseTuple(args, "idd", &param, &x, &z)) {
+        return NULL;
+    }
+    if (Generator_check_climate_param(self, param) < 0) {
+        return NULL;
+    }
+
+    double value = 0;
+    int ok;
+    GENERATOR_BEGIN_RESEED(self)
+    ok = Generator_has_climate(self);
+    if (ok) {
+        value = sampleDoublePerlin(Generator_climate(self, param), x, 0, z);
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    if (!ok) {
+        return Generator_no_climate();
+    }
+    return PyFloat_FromDouble(value);
+}
+
+static PyObject *Generator_sample_climate_points(GeneratorObject *self, PyObject *args) {
+    int param;
+    PyObject *xs_obj, *zs_obj;
+
+    if (!PyArg_ParseTuple(args, "iOO", &param, &xs_obj, &zs_obj)) {
+        return NULL;
+    }
+    if (Generator_check_climate_param(self, param) < 0) {
+        return NULL;
+    }
+
+    Py_buffer xs, zs;
+    if (get_int32_buffer(xs_obj, &xs, 0) < 0) {
+        return NULL;
+    }
+    if (get_int32_buffer(zs_obj, &zs, 0) < 0) {
+        PyBuffer_Release(&xs);
+        return NULL;
+    }
+
+    Py_ssize_t n = xs.len / xs.itemsize;
+    ArrayObject *ret = NULL;
+    int ok = 0;
+
+    if (zs.len / zs.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError, "xs and zs must have the same length");
+        goto done;
+    }
+
+    ret = Array_zeros('d', sizeof(double), n, 0);
+    if (!ret) {
+        goto done;
+    }
+    double *out = (double *)ret->data;
+
+    GENERATOR_BEGIN_RESEED(self)
+    ok = Generator_has_climate(self);
+    if (ok) {
+        const DoublePerlinNoise *noise = Generator_climate(self, param);
+        for (Py_ssize_t i = 0; i < n; i++) {
+            out[i] = sampleDoublePerlin(noise, ((const int *)xs.buf)[i], 0, ((const int *)zs.buf)[i]);
+        }
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    if (!ok) {
+        Py_CLEAR(ret);
+        Generator_no_climate();
+    }
+
+done:
+    PyBuffer_Release(&xs);
+    PyBuffer_Release(&zs);
+    return (PyObject *)ret;
+}
+
+static PyObject *Generator_sample_climate_range(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"param", "x", "z", "sx", "sz", "scale", NULL};
+
+    int param, x, z, sx, sz;
+    int scale = 4;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "iiiii|i", kwlist, &param, &x, &z, &sx, &sz, &scale)) {
+        return NULL;
+    }
+    if (Generator_check_climate_param(self, param) < 0) {
+        return NULL;
+    }
+    if (sx < 0 || sz < 0 || scale < 1) {
+        PyErr_SetString(PyExc_ValueError, "sx and sz must be non-negative and scale positive");
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('d', sizeof(double), sz, sx);
+    if (!ret) {
+        return NULL;
+    }
+    double *out = (double *)ret->data;
+    // Cell (i, j) of the range covers block ((x+i)*scale, (z+j)*scale).
+    double step = scale / 4.0;
+
+    int ok;
+    GENERATOR_BEGIN_RESEED(self)
+    ok = Generator_has_climate(self);
+    if (ok) {
+        const DoublePerlinNoise *noise = Generator_climate(self, param);
+        for (int j = 0; j < sz; j++) {
+            for (int i = 0; i < sx; i++) {
+                out[(size_t)j * sx + i] = sampleDoublePerlin(noise, (x + i) * step, 0, (z + j) * step);
+            }
+        }
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    if (!ok) {
+        Py_DECREF(ret);
+        return Generator_no_climate();
+    }
+    return (PyObject *)ret;
+}
+
+typedef struct {
+    int param;
+    double lo, hi;
+} ClimateBound;
+
+static PyObject *Generator_climate_within(GeneratorObject *self, PyObject *args) {
+    PyObject *bounds_obj, *xs_obj, *zs_obj;
+
+    if (!PyArg_ParseTuple(args, "OOO", &bounds_obj, &xs_obj, &zs_obj)) {
+        return NULL;
+    }
+
+    PyObject *fast = PySequence_Fast(bounds_obj, "bounds must be a sequence of (param, lo, hi) tuples");
+    if (!fast) {
+        return NULL;
+    }
+
+    Py_ssize_t nb = PySequence_Fast_GET_SIZE(fast);
+    ClimateBound *bounds = (ClimateBound *)malloc((nb ? nb : 1) * sizeof(ClimateBound));
+    if (!bounds) {
+        Py_DECREF(fast);
+        return PyErr_NoMemory();
+    }
+    for (Py_ssize_t i = 0; i < nb; i++) {
+        ClimateBound *b = &bounds[i];
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(fast, i), "idd:climate bound", &b->param, &b->lo, &b->hi)
+                || Generator_check_climate_param(self, b->param) < 0) {
+            free(bounds);
+            Py_DECREF(fast);
+            return NULL;
+        }
+    }
+    Py_DECREF(fast);
+
+    Py_buffer xs, zs;
+    if (get_int32_buffer(xs_obj, &xs, 0) < 0) {
+        free(bounds);
+        return NULL;
+    }
+    if (get_int32_buffer(zs_obj, &zs, 0) < 0) {
+        free(bounds);
+        PyBuffer_Release(&xs);
+        return NULL;
+    }
+
+    Py_ssize_t n = xs.len / xs.itemsize;
+    PyObject *ret = NULL;
+
+    if (zs.len / zs.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError, "xs and zs must have the same length");
+        goto done;
+    }
+
+    int ok, within = 1;
+    GENERATOR_BEGIN_RESEED(self)
+    ok = Generator_has_climate(self);
+    // One parameter at a time, so a lazily applied seed only initialises
+    // the parameters reached before the first point out of bounds.
+    for (Py_ssize_t k = 0; ok && within && k < nb; k++) {
+        const ClimateBound *b = &bounds[k];
+        const DoublePerlinNoise *noise = Generator_climate(self, b->param);
+        for (Py_ssize_t i = 0; i < n; i++) {
+            double v = sampleDoublePerlin(noise, ((const int *)xs.buf)[i], 0, ((const int *)zs.buf)[i]);
+            if (v < b->lo || v > b->hi) {
+                within = 0;
+                break;
+            }
+        }
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    if (!ok) {
+        Generator_no_climate();
+        goto done;
+    }
+    ret = PyBool_FromLong(within);
+
+done:
+    free(bounds);
+    PyBuffer_Release(&xs);
+    PyBuffer_Release(&zs);
+    return ret;
+}
+
+static PyObject *Generator_get_biome_at(GeneratorObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int scale, x, y, z;
-    
-    if (!PyArg_ParseTuple(args, "iiii", &scale, &x, &y, &z)) {
+
+    if (fastcall_nargs("get_biome_at", nargs, 4) < 0
+            || fastcall_int(args[0], &scale) < 0 || fastcall_int(args[1], &x) < 0
+            || fastcall_int(args[2], &y) < 0 || fastcall_int(args[3], &z) < 0) {
         return NULL;
     }
 
-    int id = getBiomeAt(&self->generator, scale, x, y, z);
+    int id;
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    id = getBiomeAt(&self->generator, scale, x, y, z);
+    GENERATOR_END_ALLOW_THREADS(self)
 
     return PyLong_FromLong(id);
 }
 
+typedef struct {
+    int x, y, z;
+    Py_ssize_t idx;
+} BiomePoint;
+
+static int compare_biome_point(const void *a, const void *b) {
+    const BiomePoint *p = (const BiomePoint *)a, *q = (const BiomePoint *)b;
+    if (p->y != q->y) return (p->y > q->y) - (p->y < q->y);
+    if (p->z != q->z) return (p->z > q->z) - (p->z < q->z);
+    return (p->x > q->x) - (p->x < q->x);
+}
+
+static PyObject *Generator_get_biomes_at(GeneratorObject *self, PyObject *args) {
+    int scale;
+    PyObject *xs_obj, *ys_obj, *zs_obj;
+
+    if (!PyArg_ParseTuple(args, "iOOO", &scale, &xs_obj, &ys_obj, &zs_obj)) {
+        return NULL;
+    }
+
+    Py_buffer xs, ys, zs;
+    if (get_int32_buffer(xs_obj, &xs, 0) < 0) {
+        return NULL;
+    }
+    if (get_int32_buffer(ys_obj, &ys, 0) < 0) {
+        PyBuffer_Release(&xs);
+        return NULL;
+    }
+    if (get_int32_buffer(zs_obj, &zs, 0) < 0) {
+        PyBuffer_Release(&xs);
+        PyBuffer_Release(&ys);
+        return NULL;
+    }
+
+    Py_ssize_t n = xs.len / xs.itemsize;
+    ArrayObject *ret = NULL;
+    BiomePoint *points = NULL;
+
+    if (ys.len / ys.itemsize != n || zs.len / zs.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError, "xs, ys and zs must have the same length");
+        goto done;
+    }
+
+    points = (BiomePoint *)malloc((n ? n : 1) * sizeof(BiomePoint));
+    ret = Array_zeros('i', sizeof(int), n, 0);
+    if (!points || !ret) {
+        Py_CLEAR(ret);
+        if (!PyErr_Occurred()) {
+            PyErr_NoMemory();
+        }
+        goto done;
+    }
+
+    for (Py_ssize_t i = 0; i < n; i++) {
+        points[i].x = ((const int *)xs.buf)[i];
+        points[i].y = ((const int *)ys.buf)[i];
+        points[i].z = ((const int *)zs.buf)[i];
+        points[i].idx = i;
+    }
+
+    int *ids = (int *)ret->data;
+
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    // Visiting the points in (y, z, x) order keeps neighbouring samples
+    // together and lets repeated points reuse the previous lookup.
+    qsort(points, n, sizeof(BiomePoint), compare_biome_point);
+    int id = 0;
+    for (Py_ssize_t i = 0; i < n; i++) {
+        const BiomePoint *p = &points[i];
+        if (i == 0 || compare_biome_point(p, p - 1) != 0) {
+            id = getBiomeAt(&self->generator, scale, p->x, p->y, p->z);
+        }
+        ids[p->idx] = id;
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+done:
+    free(points);
+    PyBuffer_Release(&xs);
+    PyBuffer_Release(&ys);
+    PyBuffer_Release(&zs);
+    return (PyObject *)ret;
+}
+
 static PyObject *Generator_gen_biomes(GeneratorObject *self, PyObject *args) {
     int x, y, z, sx, sy, sz, scale;
     
@@ -111,27 +660,73 @@ static PyObject *Generator_gen_biomes(GeneratorObject *self, PyObject *args) {
         return NULL;
     }
 
-    genBiomes(&self->generator, biomeIds, r);
+    int err;
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    err = genBiomes(&self->generator, biomeIds, r);
+    GENERATOR_END_ALLOW_THREADS(self)
 
-    size_t len = getMinCacheSize(&self->generator, r.scale, r.sx, r.sy, r.sz);
-    PyObject *list = PyList_New(len);
-    if (!list) {
+    if (err != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "genBiomes returned a non-zero value, indicating an error.");
         free(biomeIds);
         return NULL;
     }
 
-    for (size_t i = 0; i < len; i++) {
-        PyObject *biome_py_obj = PyLong_FromLong(biomeIds[i]);
-        if (!biome_py_obj) {
-            Py_DECREF(list);
-            free(biomeIds);
-            return NULL;
-        }
-        PyList_SetItem(list, i, biome_py_obj);
+    // The BiomeArray takes ownership of the cache.
+    return (PyObject *)BiomeArray_from_cache(biomeIds, r);
+}
+
+static PyObject *Generator_gen_biomes_into(GeneratorObject *self, PyObject *args) {
+    PyObject *buffer_obj;
+    int x, y, z, sx, sy, sz, scale;
+
+    if (!PyArg_ParseTuple(args, "Oiiiiiii", &buffer_obj, &x, &y, &z, &sx, &sy, &sz, &scale)) {
+        return NULL;
     }
-    
-    free(biomeIds);
-    return list;
+
+    Range r;
+    r.scale = scale;
+    r.x = x;
+    r.y = y;
+    r.z = z;
+    r.sx = sx;
+    r.sy = sy;
+    r.sz = sz;
+
+    Py_buffer view;
+    if (get_int32_buffer(buffer_obj, &view, 1) < 0) {
+        return NULL;
+    }
+
+    // genBiomes may use the space past sx*sy*sz as scratch memory.
+    size_t len = getMinCacheSize(&self->generator, r.scale, r.sx, r.sy, r.sz);
+    if ((size_t)(view.len / view.itemsize) < len) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "Buffer too small: %zu ints required (see get_min_cache_size)", len);
+        return NULL;
+    }
+
+    int err;
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    err = genBiomes(&self->generator, (int *)view.buf, r);
+    GENERATOR_END_ALLOW_THREADS(self)
+    PyBuffer_Release(&view);
+
+    if (err != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "genBiomes returned a non-zero value, indicating an error.");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *Generator_get_min_cache_size(GeneratorObject *self, PyObject *args) {
+    int scale, sx, sy, sz;
+
+    if (!PyArg_ParseTuple(args, "iiii", &scale, &sx, &sy, &sz)) {
+        return NULL;
+    }
+
+    size_t len = getMinCacheSize(&self->generator, scale, sx, sy, sz);
+    return PyLong_FromSize_t(len);
 }
 
 static PyObject *Generator_is_viable_structure_pos(GeneratorObject *self, PyObject *args) {
@@ -142,58 +737,783 @@ static PyObject *Generator_is_viable_structure_pos(GeneratorObject *self, PyObje
         return NULL;
     }
 
-    int ret = isViableStructurePos(structure, &self->generator, x, z, flags);
+    int ret;
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    ret = isViableStructurePos(structure, &self->generator, x, z, flags);
+    GENERATOR_END_ALLOW_THREADS(self)
     return PyBool_FromLong(ret);
 }
 
-static PyObject *Generator_map_approx_height(GeneratorObject *self, PyObject *args) {
+// Checks the size of an approximate height map.
+static int height_map_check(int w, int h) {
+    if (w < 1 || h < 1) {
+        PyErr_SetString(PyExc_ValueError, "Width and height must be positive");
+        return -1;
+    }
+    if ((Py_ssize_t)w * h > PY_SSIZE_T_MAX / (Py_ssize_t)sizeof(float)) {
+        PyErr_SetString(PyExc_OverflowError, "Height map is too large");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Maps the approximate surface height and biomes of the w x h area at
+ * (x, z) in 1:4 coordinates. Returns (heights, ids) as a float32 and an
+ * int32 Array of h rows of w values, or writes into the buffers passed as
+ * heights= and ids= and returns those.
+ *
+ * Without a SurfaceNoise the surface noise of the generator's own seed and
+ * dimension is used, taken from the noise cache when possible.
+ */
+static PyObject *Generator_map_approx_height(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"sn", "x", "z", "w", "h", "heights", "ids", NULL};
+
+    PyObject *sn_obj = NULL;
+    PyObject *heights_obj = NULL, *ids_obj = NULL;
+    int x, z, w, h;
+
+    int with_sn = (PyTuple_GET_SIZE(args) > 0 && PyObject_TypeCheck(PyTuple_GET_ITEM(args, 0), &SurfaceNoiseType))
+        || (kwds && PyDict_GetItemString(kwds, "sn"));
+    if (with_sn) {
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!iiii|$OO", kwlist, &SurfaceNoiseType, &sn_obj,
+                &x, &z, &w, &h, &heights_obj, &ids_obj)) {
+            return NULL;
+        }
+    } else if (!PyArg_ParseTupleAndKeywords(args, kwds, "iiii|$OO", kwlist + 1,
+            &x, &z, &w, &h, &heights_obj, &ids_obj)) {
+        return NULL;
+    }
+    if (height_map_check(w, h) < 0) {
+        return NULL;
+    }
+    if (heights_obj == Py_None) {
+        heights_obj = NULL;
+    }
+    if (ids_obj == Py_None) {
+        ids_obj = NULL;
+    }
+
+    Py_ssize_t n = (Py_ssize_t)w * h;
+    SurfaceNoise *own_sn = NULL;
+    Py_buffer heights_view = {0}, ids_view = {0};
+    PyObject *heights = NULL, *ids = NULL;
+    int err = 1;
+
+    if (heights_obj) {
+        if (get_float32_buffer(heights_obj, &heights_view, 1) < 0) {
+            goto done;
+        }
+        Py_INCREF(heights_obj);
+        heights = heights_obj;
+    } else if ((heights = (PyObject *)Array_zeros('f', sizeof(float), h, w))) {
+        heights_view.buf = ((ArrayObject *)heights)->data;
+        heights_view.len = n * sizeof(float);
+    } else {
+        goto done;
+    }
+
+    if (ids_obj) {
+        if (get_int32_buffer(ids_obj, &ids_view, 1) < 0) {
+            goto done;
+        }
+        Py_INCREF(ids_obj);
+        ids = ids_obj;
+    } else if ((ids = (PyObject *)Array_zeros('i', sizeof(int), h, w))) {
+        ids_view.buf = ((ArrayObject *)ids)->data;
+        ids_view.len = n * sizeof(int);
+    } else {
+        goto done;
+    }
+
+    if (heights_view.len != n * (Py_ssize_t)sizeof(float) || ids_view.len != n * (Py_ssize_t)sizeof(int)) {
+        PyErr_SetString(PyExc_ValueError, "Output buffers must hold w * h values");
+        goto done;
+    }
+
+    if (!sn_obj && !(own_sn = (SurfaceNoise *)malloc(sizeof(SurfaceNoise)))) {
+        PyErr_NoMemory();
+        goto done;
+    }
+
+    int result = 0, overworld = 1;
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    const SurfaceNoise *sn = own_sn;
+    PyThread_type_lock sn_lock = NULL;
+    if (own_sn) {
+        // Surface noise only exists for the Overworld, so an unseeded or
+        // other dimension generator must not build and cache one.
+        overworld = self->generator.dim == DIM_OVERWORLD;
+        if (overworld) {
+            surface_noise_cached(own_sn, self->generator.dim, self->generator.seed);
+        }
+    } else {
+        sn = &((SurfaceNoiseObject *)sn_obj)->noise;
+        sn_lock = ((SurfaceNoiseObject *)sn_obj)->lock;
+        PyThread_acquire_lock(sn_lock, WAIT_LOCK);
+    }
+    if (overworld) {
+        result = mapApproxHeight((float *)heights_view.buf, (int *)ids_view.buf, &self->generator, sn, x, z, w, h);
+    }
+    if (sn_lock) {
+        PyThread_release_lock(sn_lock);
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    if (!overworld) {
+        PyErr_SetString(PyExc_ValueError, "Without a SurfaceNoise the generator must be seeded for the Overworld");
+    } else if (result != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "mapApproxHeight returned a non-zero value, indicating an error.");
+    } else {
+        err = 0;
+    }
+
+done:
+    free(own_sn);
+    if (heights_obj && heights_view.obj) {
+        PyBuffer_Release(&heights_view);
+    }
+    if (ids_obj && ids_view.obj) {
+        PyBuffer_Release(&ids_view);
+    }
+    if (err) {
+        Py_XDECREF(heights);
+        Py_XDECREF(ids);
+        return NULL;
+    }
+    return Py_BuildValue("(NN)", heights, ids);
+}
+
+/*
+ * HeightTiles walks a large approximate height map a tile at a time, row by
+ * row. It maps a snapshot of the Generator and SurfaceNoise taken when it is
+ * created, and while one tile is handed out the next is mapped on the
+ * module's background thread, so at most two tiles are held natively at
+ * once.
+ */
+typedef struct {
+    float *heights;
+    int *ids;
+    int x, z, w, h;
+    int result;
+} HeightTile;
+
+typedef struct {
+    PyObject_HEAD
+    Generator generator;
+    SurfaceNoise noise;
+    int x, z, w, h, tile;
+    int64_t next_x, next_z; // origin of the tile after the pending one, past INT_MAX at the end
+    HeightTile job;
+    BackgroundTask task;      // maps job
+    int pending;
+} HeightTilesObject;
+
+static PyTypeObject HeightTilesType;
+
+static void height_tiles_worker(void *arg) {
+    HeightTilesObject *self = (HeightTilesObject *)arg;
+    HeightTile *job = &self->job;
+    job->result = mapApproxHeight(job->heights, job->ids, &self->generator, &self->noise,
+        job->x, job->z, job->w, job->h);
+}
+
+/*
+ * Queues the next tile, if any, on the background thread. Returns 0, or -1
+ * with an exception set.
+ */
+static int HeightTiles_queue(HeightTilesObject *self) {
+    int end_x = self->x + self->w, end_z = self->z + self->h;
+    if (self->next_z >= end_z) {
+        return 0;
+    }
+
+    HeightTile *job = &self->job;
+    job->x = (int)self->next_x;
+    job->z = (int)self->next_z;
+    job->w = end_x - job->x < self->tile ? end_x - job->x : self->tile;
+    job->h = end_z - job->z < self->tile ? end_z - job->z : self->tile;
+    job->heights = (float *)malloc((size_t)job->w * job->h * sizeof(float));
+    job->ids = (int *)malloc((size_t)job->w * job->h * sizeof(int));
+    if (!job->heights || !job->ids) {
+        free(job->heights);
+        free(job->ids);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    background_submit(&self->task, height_tiles_worker, self);
+    self->pending = 1;
+
+    self->next_x += self->tile;
+    if (self->next_x >= end_x) {
+        self->next_x = self->x;
+        self->next_z += self->tile;
+    }
+    return 0;
+}
+
+// Waits for the pending tile, or drops it if it has not started.
+static void HeightTiles_wait(HeightTilesObject *self, int cancel) {
+    Py_BEGIN_ALLOW_THREADS
+    background_wait(&self->task, cancel);
+    Py_END_ALLOW_THREADS
+    self->pending = 0;
+}
+
+static void HeightTiles_dealloc(HeightTilesObject *self) {
+    if (self->pending) {
+        HeightTiles_wait(self, 1);
+        free(self->job.heights);
+        free(self->job.ids);
+    }
+    background_task_free(&self->task);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *HeightTiles_iter(HeightTilesObject *self) {
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *HeightTiles_next(HeightTilesObject *self) {
+    if (!self->pending) {
+        return NULL;
+    }
+    HeightTiles_wait(self, 0);
+    HeightTile tile = self->job;
+
+    if (tile.result != 0) {
+        free(tile.heights);
+        free(tile.ids);
+        PyErr_SetString(PyExc_RuntimeError, "mapApproxHeight returned a non-zero value, indicating an error.");
+        return NULL;
+    }
+    if (HeightTiles_queue(self) < 0) {
+        free(tile.heights);
+        free(tile.ids);
+        return NULL;
+    }
+
+    PyObject *ids = (PyObject *)Array_from_data(tile.ids, 'i', sizeof(int), tile.h, tile.w);
+    if (!ids) {
+        free(tile.heights);
+        return NULL;
+    }
+    PyObject *heights = (PyObject *)Array_from_data(tile.heights, 'f', sizeof(float), tile.h, tile.w);
+    if (!heights) {
+        Py_DECREF(ids);
+        return NULL;
+    }
+    return Py_BuildValue("(iiNN)", tile.x, tile.z, heights, ids);
+}
+
+static PyTypeObject HeightTilesType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.HeightTiles",
+    .tp_doc = "Iterator over the tiles of an approximate height map, as (x, z, heights, ids)",
+    .tp_basicsize = sizeof(HeightTilesObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) HeightTiles_dealloc,
+    .tp_iter = (getiterfunc) HeightTiles_iter,
+    .tp_iternext = (iternextfunc) HeightTiles_next,
+};
+
+static PyObject *Generator_iter_height_tiles(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"sn", "x", "z", "w", "h", "tile", NULL};
+
     PyObject *sn_obj;
     int x, z, w, h;
-    
-    if (!PyArg_ParseTuple(args, "O!iiii", &SurfaceNoiseType, &sn_obj, &x, &z, &w, &h)) {
+    int tile = 256;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!iiii|i", kwlist, &SurfaceNoiseType, &sn_obj,
+            &x, &z, &w, &h, &tile)) {
         return NULL;
     }
-    
+    if (height_map_check(w, h) < 0) {
+        return NULL;
+    }
+    if (tile < 1 || tile > 4096) {
+        PyErr_SetString(PyExc_ValueError, "tile must be between 1 and 4096");
+        return NULL;
+    }
+    if ((int64_t)x + w > INT_MAX || (int64_t)z + h > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "Height map extends past the coordinate range");
+        return NULL;
+    }
+
+    HeightTilesObject *tiles = PyObject_New(HeightTilesObject, &HeightTilesType);
+    if (!tiles) {
+        return NULL;
+    }
+    tiles->pending = 0;
+    if (background_task_init(&tiles->task) < 0) {
+        Py_DECREF(tiles);
+        return PyErr_NoMemory();
+    }
+
     SurfaceNoiseObject *sn = (SurfaceNoiseObject *)sn_obj;
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(sn->lock, WAIT_LOCK);
+    memcpy(&tiles->noise, &sn->noise, sizeof(SurfaceNoise));
+    rebase_surface_noise(&tiles->noise, &sn->noise);
+    PyThread_release_lock(sn->lock);
+    Py_END_ALLOW_THREADS
 
-    float *y = (float *)malloc(w * h * sizeof(float));
-    int *ids = (int *)malloc(w * h * sizeof(int));
-    
-    if (!y || !ids) {
-        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory.");
-        free(y);
-        free(ids);
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    memcpy(&tiles->generator, &self->generator, sizeof(Generator));
+    rebase_generator(&tiles->generator, &self->generator);
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    tiles->x = tiles->next_x = x;
+    tiles->z = tiles->next_z = z;
+    tiles->w = w;
+    tiles->h = h;
+    tiles->tile = tile;
+
+    if (HeightTiles_queue(tiles) < 0) {
+        Py_DECREF(tiles);
         return NULL;
     }
-	
-    int result = mapApproxHeight(y, ids, &self->generator, &sn->noise, x, z, w, h);
+    return (PyObject *)tiles;
+}
 
-    if (result != 0) {
-        PyErr_SetString(PyExc_RuntimeError, "mapApproxHeight returned a non-zero value, indicating an error.");
-        free(y);
-        free(ids);
+typedef struct {
+    uint64_t lower48;
+    int dim;
+    const SeedCheck *checks;
+    Py_ssize_t check_count;
+    ResultBuf *results;
+} SeedExpansion;
+
+static void seed_expansion_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    SeedExpansion *ex = (SeedExpansion *)arg;
+    Generator *g = pool_generator(tid);
+
+    for (uint64_t upper16 = lo; upper16 < hi; upper16++) {
+        uint64_t seed = (upper16 << 48) | ex->lower48;
+        applySeed(g, ex->dim, seed);
+        if (seed_checks_pass(ex->checks, ex->check_count, g)) {
+            resultbuf_push(&ex->results[tid], &seed);
+        }
+    }
+}
+
+static PyObject *Generator_expand_structure_seed(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"lower48", "checks", "dim", "threads", NULL};
+
+    SeedExpansion ex = {0};
+    PyObject *checks_obj;
+    int threads = 0;
+
+    ex.dim = DIM_OVERWORLD;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "KO|ii", kwlist, &ex.lower48, &checks_obj, &ex.dim, &threads)) {
         return NULL;
     }
-    PyObject *y_list = PyList_New(w * h);
-    PyObject *ids_list = PyList_New(w * h);
-    
-    for (int i = 0; i < w * h; i++) {
-        PyList_SetItem(y_list, i, PyFloat_FromDouble(y[i]));
-        PyList_SetItem(ids_list, i, PyLong_FromLong(ids[i]));
+
+    if (ex.lower48 >> 48) {
+        PyErr_SetString(PyExc_ValueError, "lower48 must fit in 48 bits");
+        return NULL;
     }
-    
-    free(y);
-    free(ids);
-    
-    return PyTuple_Pack(2, y_list, ids_list);
+
+    SeedCheck *checks;
+    ex.check_count = parse_seed_checks(checks_obj, &checks);
+    if (ex.check_count < 0) {
+        return NULL;
+    }
+    ex.checks = checks;
+
+    threads = resolve_thread_count(threads);
+    ex.results = (ResultBuf *)malloc(threads * sizeof(ResultBuf));
+    if (!ex.results) {
+        free(checks);
+        return PyErr_NoMemory();
+    }
+
+    uint64_t *seeds = NULL;
+    size_t len;
+    int failed = 1;
+    int mc;
+    uint32_t flags;
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(self->lock, WAIT_LOCK);
+    mc = self->generator.mc;
+    flags = self->generator.flags;
+    PyThread_release_lock(self->lock);
+
+    // Every thread gets a pool generator with the same version and flags.
+    threads = pool_begin(threads);
+    if (pool_generators(threads, mc, flags) == 0) {
+        for (int i = 0; i < threads; i++) {
+            resultbuf_init(&ex.results[i], sizeof(uint64_t));
+        }
+        pool_run(0, 1 << 16, 256, threads, seed_expansion_worker, &ex);
+        seeds = (uint64_t *)resultbuf_merge(ex.results, threads, &len, &failed);
+    }
+    pool_end();
+    if (seeds) {
+        qsort(seeds, len, sizeof(uint64_t), compare_u64);
+    }
+    Py_END_ALLOW_THREADS
+
+    free(ex.results);
+    free(checks);
+
+    if (failed) {
+        free(seeds);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)Array_from_data(seeds, 'Q', sizeof(uint64_t), len, 0);
+}
+
+typedef struct {
+    const uint64_t *seeds;
+    int dim;
+    int scale;
+    const int *points;    // x, y, z triples
+    Py_ssize_t point_count;
+    const int *expected;  // mask mode when set
+    char *out;
+} SeedSampling;
+
+static void seed_sampling_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    SeedSampling *ss = (SeedSampling *)arg;
+    Generator *g = pool_generator(tid);
+    Py_ssize_t m = ss->point_count;
+
+    for (uint64_t i = lo; i < hi; i++) {
+        applySeed(g, ss->dim, ss->seeds[i]);
+
+        if (ss->expected) {
+            uint8_t match = 1;
+            for (Py_ssize_t j = 0; j < m && match; j++) {
+                const int *p = ss->points + 3*j;
+                match = getBiomeAt(g, ss->scale, p[0], p[1], p[2]) == ss->expected[j];
+            }
+            ((uint8_t *)ss->out)[i] = match;
+        } else {
+            int *row = (int *)ss->out + i * m;
+            for (Py_ssize_t j = 0; j < m; j++) {
+                const int *p = ss->points + 3*j;
+                row[j] = getBiomeAt(g, ss->scale, p[0], p[1], p[2]);
+            }
+        }
+    }
+}
+
+static PyObject *Generator_sample_seeds(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"seeds", "dim", "points", "scale", "expected", "threads", NULL};
+
+    SeedSampling ss = {0};
+    PyObject *seeds_obj, *points_obj, *expected_obj = Py_None;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OiOi|Oi", kwlist, &seeds_obj, &ss.dim, &points_obj, &ss.scale, &expected_obj, &threads)) {
+        return NULL;
+    }
+
+    PyObject *points_fast = PySequence_Fast(points_obj, "points must be a sequence of (x, y, z) tuples");
+    if (!points_fast) {
+        return NULL;
+    }
+    PyObject *expected_fast = NULL;
+    if (expected_obj != Py_None) {
+        expected_fast = PySequence_Fast(expected_obj, "expected must be a sequence of biome ids");
+        if (!expected_fast) {
+            Py_DECREF(points_fast);
+            return NULL;
+        }
+    }
+
+    Py_buffer seeds;
+    if (get_int64_buffer(seeds_obj, &seeds, 0) < 0) {
+        Py_DECREF(points_fast);
+        Py_XDECREF(expected_fast);
+        return NULL;
+    }
+
+    Py_ssize_t n = seeds.len / seeds.itemsize;
+    Py_ssize_t m = PySequence_Fast_GET_SIZE(points_fast);
+    int *points = (int *)malloc((3 * m + 1) * sizeof(int));
+    int *expected = (int *)malloc((m + 1) * sizeof(int));
+    ArrayObject *ret = NULL;
+
+    if (!points || !expected) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    if (m == 0) {
+        PyErr_SetString(PyExc_ValueError, "points must not be empty");
+        goto done;
+    }
+
+    for (Py_ssize_t j = 0; j < m; j++) {
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(points_fast, j), "iii:point", &points[3*j], &points[3*j+1], &points[3*j+2])) {
+            goto done;
+        }
+    }
+
+    if (expected_fast) {
+        if (PySequence_Fast_GET_SIZE(expected_fast) != m) {
+            PyErr_SetString(PyExc_ValueError, "expected must have one biome per point");
+            goto done;
+        }
+        for (Py_ssize_t j = 0; j < m; j++) {
+            if (fastcall_int(PySequence_Fast_GET_ITEM(expected_fast, j), &expected[j]) < 0) {
+                goto done;
+            }
+        }
+        ret = Array_zeros('B', 1, n, 0);
+    } else {
+        ret = Array_zeros('i', sizeof(int), n, m);
+    }
+    if (!ret) {
+        goto done;
+    }
+
+    threads = resolve_thread_count(threads);
+    ss.seeds = (const uint64_t *)seeds.buf;
+    ss.points = points;
+    ss.point_count = m;
+    ss.expected = expected_fast ? expected : NULL;
+    ss.out = ret->data;
+
+    int mc, failed;
+    uint32_t flags;
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(self->lock, WAIT_LOCK);
+    mc = self->generator.mc;
+    flags = self->generator.flags;
+    PyThread_release_lock(self->lock);
+
+    threads = pool_begin(threads);
+    failed = pool_generators(threads, mc, flags) < 0;
+    if (!failed) {
+        pool_run(0, n, 64, threads, seed_sampling_worker, &ss);
+    }
+    pool_end();
+    Py_END_ALLOW_THREADS
+
+    if (failed) {
+        Py_CLEAR(ret);
+        PyErr_NoMemory();
+    }
+
+done:
+    free(points);
+    free(expected);
+    PyBuffer_Release(&seeds);
+    Py_DECREF(points_fast);
+    Py_XDECREF(expected_fast);
+    return (PyObject *)ret;
+}
+
+/*
+ * Renders the biomes of a Range with sy of 1 as an RGB image of
+ * sx * pixscale by sz * pixscale pixels, with one row of pixels per z.
+ * Returns the malloc'd pixels, or NULL with an exception set.
+ */
+static unsigned char *Generator_render(GeneratorObject *self, PyObject *range_obj, PyObject *colors_obj,
+        PyObject *structures_obj, int pixscale, int threads, size_t *width, size_t *height) {
+    Range r = ((RangeObject *)range_obj)->range;
+    if (r.sy > 1 || r.sx < 1 || r.sz < 1) {
+        PyErr_SetString(PyExc_ValueError, "Range must be a positive sx by sz area with sy of 1");
+        return NULL;
+    }
+    r.sy = 1;
+    if (pixscale < 1 || pixscale > 64) {
+        PyErr_SetString(PyExc_ValueError, "pixscale must be between 1 and 64");
+        return NULL;
+    }
+    *width = (size_t)r.sx * pixscale;
+    *height = (size_t)r.sz * pixscale;
+    if (*width > (size_t)PY_SSIZE_T_MAX / 3 / *height) {
+        PyErr_SetString(PyExc_OverflowError, "Image is too large");
+        return NULL;
+    }
+
+    BiomeRender rd = {0};
+    unsigned char colors[256][3];
+    int types[RENDER_MAX_STRUCTURES];
+    int mc;
+    uint32_t flags;
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(self->lock, WAIT_LOCK);
+    mc = self->generator.mc;
+    flags = self->generator.flags;
+    PyThread_release_lock(self->lock);
+    Py_END_ALLOW_THREADS
+
+    int type_count = render_parse_structures(structures_obj, mc, types);
+    if (type_count < 0 || render_parse_colors(colors_obj, colors) < 0) {
+        return NULL;
+    }
+
+    threads = resolve_thread_count(threads);
+    rd.range = r;
+    rd.pixscale = pixscale;
+    rd.width = *width;
+    rd.colors = colors;
+    rd.pixels = (unsigned char *)malloc(*width * *height * 3);
+    rd.caches = (int **)calloc(threads, sizeof(int *));
+    if (!rd.pixels || !rd.caches) {
+        free(rd.pixels);
+        free(rd.caches);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    int failed = 0;
+    GENERATOR_BEGIN_ALLOW_THREADS(self)
+    size_t cache_len = getMinCacheSize(&self->generator, r.scale, r.sx, 1, RENDER_STRIPE);
+    threads = pool_begin(threads);
+    for (int i = 0; i < threads && !failed; i++) {
+        failed = !(rd.caches[i] = (int *)malloc(cache_len * sizeof(int)));
+    }
+    if (!failed && pool_generators(threads, mc, flags) == 0) {
+        // Every thread renders from its own copy of the seeded generator.
+        for (int i = 0; i < threads; i++) {
+            memcpy(pool_generator(i), &self->generator, sizeof(Generator));
+            rebase_generator(pool_generator(i), &self->generator);
+        }
+        pool_run(0, r.sz, RENDER_STRIPE, threads, render_worker, &rd);
+    } else {
+        failed = 1;
+    }
+    pool_end();
+    if (!failed && !rd.failed) {
+        render_structures(&rd, &self->generator, types, type_count, *height);
+    }
+    GENERATOR_END_ALLOW_THREADS(self)
+
+    for (int i = 0; i < threads; i++) {
+        free(rd.caches[i]);
+    }
+    free(rd.caches);
+
+    if (failed || rd.failed) {
+        free(rd.pixels);
+        if (failed) {
+            PyErr_NoMemory();
+        } else {
+            PyErr_SetString(PyExc_RuntimeError, "genBiomes returned a non-zero value, indicating an error.");
+        }
+        return NULL;
+    }
+    return rd.pixels;
+}
+
+static PyObject *Generator_render_to_buffer(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"range", "colors", "structures", "pixscale", "threads", NULL};
+
+    PyObject *range_obj;
+    PyObject *colors_obj = NULL, *structures_obj = NULL;
+    int pixscale = 1;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|$OOii", kwlist, &RangeType, &range_obj,
+            &colors_obj, &structures_obj, &pixscale, &threads)) {
+        return NULL;
+    }
+
+    size_t width, height;
+    unsigned char *pixels = Generator_render(self, range_obj, colors_obj, structures_obj, pixscale, threads, &width, &height);
+    if (!pixels) {
+        return NULL;
+    }
+    return (PyObject *)Array_from_data_3d(pixels, 'B', 1, height, width, 3);
+}
+
+static PyObject *Generator_render_biomes(GeneratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"range", "path", "format", "colors", "structures", "pixscale", "threads", NULL};
+
+    PyObject *range_obj, *path;
+    const char *format = NULL;
+    PyObject *colors_obj = NULL, *structures_obj = NULL;
+    int pixscale = 1;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&|$zOOii", kwlist, &RangeType, &range_obj,
+            PyUnicode_FSConverter, &path, &format, &colors_obj, &structures_obj, &pixscale, &threads)) {
+        return NULL;
+    }
+
+    // Without a format the file suffix decides, defaulting to PPM.
+    const char *name = PyBytes_AS_STRING(path);
+    size_t len = strlen(name);
+    int png;
+    if (format) {
+        png = strcmp(format, "png") == 0;
+        if (!png && strcmp(format, "ppm") != 0) {
+            Py_DECREF(path);
+            PyErr_Format(PyExc_ValueError, "Unknown image format '%s' (expected 'ppm' or 'png')", format);
+            return NULL;
+        }
+    } else {
+        png = len >= 4 && (strcmp(name + len - 4, ".png") == 0 || strcmp(name + len - 4, ".PNG") == 0);
+    }
+
+    size_t width, height;
+    unsigned char *pixels = Generator_render(self, range_obj, colors_obj, structures_obj, pixscale, threads, &width, &height);
+    if (!pixels) {
+        Py_DECREF(path);
+        return NULL;
+    }
+
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    errno = 0;
+    if (png) {
+        err = save_png(name, pixels, width, height);
+    } else if (width > UINT_MAX || height > UINT_MAX) {
+        err = -1;
+    } else {
+        err = savePPM(name, pixels, (unsigned int)width, (unsigned int)height);
+    }
+    Py_END_ALLOW_THREADS
+    free(pixels);
+
+    if (err) {
+        if (errno) {
+            PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+        } else {
+            PyErr_SetString(PyExc_ValueError, "Image is too large for the file format");
+        }
+        Py_DECREF(path);
+        return NULL;
+    }
+    Py_DECREF(path);
+    Py_RETURN_NONE;
 }
 
 static PyMethodDef Generator_methods[] = {
-    {"apply_seed", (PyCFunction) Generator_apply_seed, METH_VARARGS, "Applies a seed to the generator"},
-    {"get_biome_at", (PyCFunction) Generator_get_biome_at, METH_VARARGS, "Get the biome at the specified location"},
-    {"gen_biomes", (PyCFunction) Generator_gen_biomes, METH_VARARGS, "Get the biome at the specified location"},
+    {"apply_seed", (PyCFunction) Generator_apply_seed, METH_VARARGS | METH_KEYWORDS, "Applies a seed to the generator; with lazy=True the 1.18+ climate noise is initialised per parameter on first use, and with cache=True the seeded state is reused through the noise cache"},
+    {"copy", (PyCFunction) Generator_copy, METH_NOARGS, "Returns a copy of the generator, cloning its seeded noise instead of applying the seed again"},
+    {"__copy__", (PyCFunction) Generator_copy, METH_NOARGS, "Returns a copy of the generator"},
+    {"__deepcopy__", (PyCFunction) Generator_deepcopy, METH_O, "Returns a copy of the generator"},
+    {"__reduce__", (PyCFunction) Generator_reduce, METH_NOARGS, "Pickles the generator as its version, flags, seed and dimension"},
+    {"__setstate__", (PyCFunction) Generator_setstate, METH_O, "Applies the (seed, dim, lazy) state of a pickled generator"},
+    {"sample_climate", (PyCFunction) Generator_sample_climate, METH_VARARGS, "Samples a climate parameter's noise at 1:4 scale coordinates x, z"},
+    {"sample_climate_points", (PyCFunction) Generator_sample_climate_points, METH_VARARGS, "Samples a climate parameter at the 1:4 points in the int32 buffers xs, zs, returning float64 values"},
+    {"sample_climate_range", (PyCFunction) Generator_sample_climate_range, METH_VARARGS | METH_KEYWORDS, "Samples a climate parameter over an sx by sz area at the given scale, returning a (sz, sx) float64 array"},
+    {"climate_within", (PyCFunction) Generator_climate_within, METH_VARARGS, "Checks that every 1:4 point in xs, zs has each (param, lo, hi) climate bound satisfied"},
+    {"get_biome_at", FASTCALL(Generator_get_biome_at), METH_FASTCALL, "Get the biome at the specified location"},
+    {"get_biomes_at", (PyCFunction) Generator_get_biomes_at, METH_VARARGS, "Get the biomes at the points given by int32 buffers xs, ys and zs"},
+    {"gen_biomes", (PyCFunction) Generator_gen_biomes, METH_VARARGS, "Generates the biomes for a cuboidal range as a BiomeArray"},
+    {"gen_biomes_into", (PyCFunction) Generator_gen_biomes_into, METH_VARARGS, "Generates the biomes for a cuboidal range into a writable int32 buffer"},
+    {"render_biomes", (PyCFunction) Generator_render_biomes, METH_VARARGS | METH_KEYWORDS, "Renders the biomes of a Range with sy of 1 to a PPM or PNG file, optionally marking the viable positions of the given structures"},
+    {"render_to_buffer", (PyCFunction) Generator_render_to_buffer, METH_VARARGS | METH_KEYWORDS, "Renders the biomes of a Range with sy of 1 as an RGB Array of shape (height, width, 3)"},
+    {"get_min_cache_size", (PyCFunction) Generator_get_min_cache_size, METH_VARARGS, "Gets the number of ints a buffer needs for gen_biomes_into"},
     {"is_viable_structure_pos", (PyCFunction) Generator_is_viable_structure_pos, METH_VARARGS, "Get the biome at the specified location"},
-    {"map_approx_height", (PyCFunction)Generator_map_approx_height, METH_VARARGS, "Maps an approximation of the Overworld surface height."},
+    {"map_approx_height", (PyCFunction)Generator_map_approx_height, METH_VARARGS | METH_KEYWORDS, "Maps an approximation of the Overworld surface height as (heights, ids) float32 and int32 Arrays, or into the heights= and ids= buffers; without a SurfaceNoise the generator's seed is used through the noise cache"},
+    {"iter_height_tiles", (PyCFunction)Generator_iter_height_tiles, METH_VARARGS | METH_KEYWORDS, "Iterates over an approximate height map in tiles of at most tile x tile as (x, z, heights, ids), mapping the next tile in the background"},
+    {"sample_seeds", (PyCFunction)Generator_sample_seeds, METH_VARARGS | METH_KEYWORDS, "Samples the biomes at fixed points for many seeds, or with expected= a match mask, using native threads"},
+    {"expand_structure_seed", (PyCFunction)Generator_expand_structure_seed, METH_VARARGS | METH_KEYWORDS, "Finds the world seeds with the given lower 48 bits that pass all checks, using native threads"},
     {NULL}  /* Sentinel */
 };
 
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <math.h>
 
 #define PY_SSIZE_T_CLEAN
@@ -15,6 +16,235 @@ extern PyTypeObject PerlinNoiseType;
 extern PyTypeObject OctaveNoiseType;
 extern PyTypeObject DoublePerlinNoiseType;
 
+/******************************************************************************
+ * Bulk sampling
+ *
+ * sample_grid and sample_points evaluate a noise at many coordinates in one
+ * call, with the GIL released and the points split across the shared thread
+ * pool. The points are evaluated with the cubiomes samplers themselves, so
+ * bulk results are identical to sampling one coordinate at a time.
+ *
+ * While a bulk sample runs the noise is read from other threads, so init
+ * refuses to reseed a noise that is being sampled.
+ ******************************************************************************/
+
+#define NOISE_CHUNK 4096
+
+typedef double (*noise_sampler)(const void *noise, double x, double y, double z);
+
+typedef struct {
+    noise_sampler fn;
+    const void *noise;
+    // Grid: points are ordered y, z, x, with x varying fastest.
+    double x0, y0, z0, step;
+    int nx, nz;
+    // Points
+    const double *xs, *ys, *zs;
+    double *out;
+} NoiseSampling;
+
+static void noise_grid_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    const NoiseSampling *s = (const NoiseSampling *)arg;
+
+    for (uint64_t i = lo; i < hi; i++) {
+        uint64_t row = i / s->nx;
+        double x = s->x0 + (double)(i % s->nx) * s->step;
+        double y = s->y0 + (double)(row / s->nz) * s->step;
+        double z = s->z0 + (double)(row % s->nz) * s->step;
+        s->out[i] = s->fn(s->noise, x, y, z);
+    }
+}
+
+static void noise_points_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    const NoiseSampling *s = (const NoiseSampling *)arg;
+
+    for (uint64_t i = lo; i < hi; i++) {
+        s->out[i] = s->fn(s->noise, s->xs[i], s->ys[i], s->zs[i]);
+    }
+}
+
+static int noise_check_idle(int busy) {
+    if (busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Noise is being sampled");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *noise_sample(noise_sampler fn, const void *noise, PyObject *args) {
+    double x, y, z;
+
+    if (!PyArg_ParseTuple(args, "ddd", &x, &y, &z)) {
+        return NULL;
+    }
+    return PyFloat_FromDouble(fn(noise, x, y, z));
+}
+
+/*
+ * Samples an nx x ny x nz grid starting at (x0, y0, z0) with the given
+ * spacing. Returns a float64 Array of ny * nz rows of nx values, the rows
+ * ordered by y and then z, so it reshapes to (ny, nz, nx).
+ */
+static PyObject *noise_sample_grid(noise_sampler fn, const void *noise, int *busy, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"x0", "y0", "z0", "nx", "ny", "nz", "step", "threads", NULL};
+
+    double x0, y0, z0, step = 1.0;
+    int nx, ny, nz;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "dddiii|d$i", kwlist,
+            &x0, &y0, &z0, &nx, &ny, &nz, &step, &threads)) {
+        return NULL;
+    }
+    if (nx < 1 || ny < 1 || nz < 1) {
+        PyErr_SetString(PyExc_ValueError, "Grid dimensions must be positive");
+        return NULL;
+    }
+    Py_ssize_t rows = (Py_ssize_t)ny * nz;
+    if (rows > PY_SSIZE_T_MAX / (Py_ssize_t)sizeof(double) / nx) {
+        PyErr_SetString(PyExc_OverflowError, "Grid is too large");
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('d', sizeof(double), rows, nx);
+    if (!ret) {
+        return NULL;
+    }
+
+    NoiseSampling s = {0};
+    s.fn = fn;
+    s.noise = noise;
+    s.x0 = x0;
+    s.y0 = y0;
+    s.z0 = z0;
+    s.step = step;
+    s.nx = nx;
+    s.nz = nz;
+    s.out = (double *)ret->data;
+
+    (*busy)++;
+    Py_BEGIN_ALLOW_THREADS
+    parallel_range(0, (uint64_t)rows * nx, NOISE_CHUNK, threads, noise_grid_worker, &s);
+    Py_END_ALLOW_THREADS
+    (*busy)--;
+
+    return (PyObject *)ret;
+}
+
+/*
+ * Samples the points (xs[i], ys[i], zs[i]) given as three float64 buffers
+ * of equal length. Returns a float64 Array of one value per point.
+ */
+static PyObject *noise_sample_points(noise_sampler fn, const void *noise, int *busy, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"xs", "ys", "zs", "threads", NULL};
+
+    PyObject *xs_obj, *ys_obj, *zs_obj;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|$i", kwlist, &xs_obj, &ys_obj, &zs_obj, &threads)) {
+        return NULL;
+    }
+
+    Py_buffer xs, ys, zs;
+    if (get_float64_buffer(xs_obj, &xs, 0) < 0) {
+        return NULL;
+    }
+    if (get_float64_buffer(ys_obj, &ys, 0) < 0) {
+        PyBuffer_Release(&xs);
+        return NULL;
+    }
+    if (get_float64_buffer(zs_obj, &zs, 0) < 0) {
+        PyBuffer_Release(&xs);
+        PyBuffer_Release(&ys);
+        return NULL;
+    }
+
+    Py_ssize_t n = xs.len / xs.itemsize;
+    ArrayObject *ret = NULL;
+    if (ys.len / ys.itemsize != n || zs.len / zs.itemsize != n) {
+        PyErr_SetString(PyExc_ValueError, "xs, ys and zs must have the same length");
+    } else if ((ret = Array_zeros('d', sizeof(double), n, 0))) {
+        NoiseSampling s = {0};
+        s.fn = fn;
+        s.noise = noise;
+        s.xs = (const double *)xs.buf;
+        s.ys = (const double *)ys.buf;
+        s.zs = (const double *)zs.buf;
+        s.out = (double *)ret->data;
+
+        (*busy)++;
+        Py_BEGIN_ALLOW_THREADS
+        parallel_range(0, (uint64_t)n, NOISE_CHUNK, threads, noise_points_worker, &s);
+        Py_END_ALLOW_THREADS
+        (*busy)--;
+    }
+
+    PyBuffer_Release(&xs);
+    PyBuffer_Release(&ys);
+    PyBuffer_Release(&zs);
+    return (PyObject *)ret;
+}
+
+// Reads the optional Xoroshiro amplitudes, one per octave; NULL means len ones.
+static double *noise_amplitudes(PyObject *obj, int len) {
+    double *amp = (double *)malloc(len * sizeof(double));
+    if (!amp) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    if (!obj || obj == Py_None) {
+        for (int i = 0; i < len; i++) {
+            amp[i] = 1.0;
+        }
+        return amp;
+    }
+
+    PyObject *seq = PySequence_Fast(obj, "amplitudes must be a sequence of floats");
+    if (!seq) {
+        free(amp);
+        return NULL;
+    }
+    if (PySequence_Fast_GET_SIZE(seq) != len) {
+        PyErr_SetString(PyExc_ValueError, "amplitudes must have one value per octave");
+        Py_DECREF(seq);
+        free(amp);
+        return NULL;
+    }
+    for (int i = 0; i < len; i++) {
+        amp[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+        if (amp[i] == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            free(amp);
+            return NULL;
+        }
+    }
+    Py_DECREF(seq);
+    return amp;
+}
+
+/*
+ * Checks the octave range of an OctaveNoise or DoublePerlinNoise init. Both
+ * initialisers only support octaves up to 2**0, and the Xoroshiro one has
+ * octave seeds down to 2**-12.
+ */
+static int noise_check_octaves(int omin, int len, int xoroshiro, PyObject *amplitudes) {
+    if (len < 1 || len > 32) {
+        PyErr_SetString(PyExc_ValueError, "length must be between 1 and 32");
+        return -1;
+    }
+    if (!xoroshiro && amplitudes && amplitudes != Py_None) {
+        PyErr_SetString(PyExc_ValueError, "amplitudes are only used with xoroshiro=True");
+        return -1;
+    }
+    if (omin + len - 1 > 0 || (xoroshiro && omin < -12)) {
+        PyErr_SetString(PyExc_ValueError, xoroshiro ?
+            "Octaves must lie between omin >= -12 and omin + length - 1 <= 0" :
+            "omin + length - 1 must not be positive");
+        return -1;
+    }
+    return 0;
+}
+
 /******************************************************************************
  * PerlinNoise Object
  ******************************************************************************/
@@ -22,15 +252,59 @@ extern PyTypeObject DoublePerlinNoiseType;
 typedef struct {
     PyObject_HEAD
     PerlinNoise noise;
+    int busy;
 } PerlinNoiseObject;
 
 static int PerlinNoise_init(PerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    if (noise_check_idle(self->busy) < 0) {
+        return -1;
+    }
     self->noise = (PerlinNoise){0};
     return 0;
 }
 
+static double perlin_sampler(const void *noise, double x, double y, double z) {
+    return samplePerlin((const PerlinNoise *)noise, x, y, z, 0, 0);
+}
+
+static PyObject *PerlinNoise_init_noise(PerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"seed", "xoroshiro", NULL};
+
+    uint64_t seed;
+    int xoroshiro = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "K|$p", kwlist, &seed, &xoroshiro)) {
+        return NULL;
+    }
+    if (noise_check_idle(self->busy) < 0) {
+        return NULL;
+    }
+
+    if (xoroshiro) {
+        Xoroshiro xr;
+        xSetSeed(&xr, seed);
+        xPerlinInit(&self->noise, &xr);
+    } else {
+        uint64_t rnd;
+        setSeed(&rnd, seed);
+        perlinInit(&self->noise, &rnd);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *PerlinNoise_sample(PerlinNoiseObject *self, PyObject *args) {
+    return noise_sample(perlin_sampler, &self->noise, args);
+}
+
+static PyObject *PerlinNoise_sample_grid(PerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    return noise_sample_grid(perlin_sampler, &self->noise, &self->busy, args, kwds);
+}
+
+static PyObject *PerlinNoise_sample_points(PerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    return noise_sample_points(perlin_sampler, &self->noise, &self->busy, args, kwds);
+}
+
 static void PerlinNoise_dealloc(PerlinNoiseObject *self) {
-    PyObject_GC_UnTrack(self);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
@@ -43,6 +317,10 @@ static PyMemberDef PerlinNoise_members[] = {
 };
 
 static PyMethodDef PerlinNoise_methods[] = {
+    {"init", (PyCFunction) PerlinNoise_init_noise, METH_VARARGS | METH_KEYWORDS, "Seeds the noise from a Java Random seed, or from a Xoroshiro seed with xoroshiro=True"},
+    {"sample", (PyCFunction) PerlinNoise_sample, METH_VARARGS, "Samples the noise at (x, y, z)"},
+    {"sample_grid", (PyCFunction) PerlinNoise_sample_grid, METH_VARARGS | METH_KEYWORDS, "Samples an nx x ny x nz grid from (x0, y0, z0) with the given step as a float64 Array of shape (ny * nz, nx)"},
+    {"sample_points", (PyCFunction) PerlinNoise_sample_points, METH_VARARGS | METH_KEYWORDS, "Samples the points given by three float64 buffers xs, ys and zs as a float64 Array"},
     {NULL}  /* Sentinel */
 };
 
@@ -68,24 +346,92 @@ PyTypeObject PerlinNoiseType = {
 typedef struct {
     PyObject_HEAD
     OctaveNoise noise;
+    PerlinNoise *octaves;   // owned storage noise.octaves points into
+    int busy;
 } OctaveNoiseObject;
 
 static int OctaveNoise_init(OctaveNoiseObject *self, PyObject *args, PyObject *kwds) {
+    if (noise_check_idle(self->busy) < 0) {
+        return -1;
+    }
+    free(self->octaves);
+    self->octaves = NULL;
     self->noise = (OctaveNoise){0};
     return 0;
 }
 
 static void OctaveNoise_dealloc(OctaveNoiseObject *self) {
-    PyObject_GC_UnTrack(self);
+    free(self->octaves);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
+static double octave_sampler(const void *noise, double x, double y, double z) {
+    return sampleOctave((const OctaveNoise *)noise, x, y, z);
+}
+
+static PyObject *OctaveNoise_init_noise(OctaveNoiseObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"seed", "omin", "length", "xoroshiro", "amplitudes", NULL};
+
+    uint64_t seed;
+    int omin, len;
+    int xoroshiro = 0;
+    PyObject *amplitudes = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Kii|$pO", kwlist, &seed, &omin, &len, &xoroshiro, &amplitudes)) {
+        return NULL;
+    }
+    if (noise_check_idle(self->busy) < 0 || noise_check_octaves(omin, len, xoroshiro, amplitudes) < 0) {
+        return NULL;
+    }
+
+    PerlinNoise *octaves = (PerlinNoise *)calloc(len, sizeof(PerlinNoise));
+    if (!octaves) {
+        return PyErr_NoMemory();
+    }
+
+    if (xoroshiro) {
+        double *amp = noise_amplitudes(amplitudes, len);
+        if (!amp) {
+            free(octaves);
+            return NULL;
+        }
+        Xoroshiro xr;
+        xSetSeed(&xr, seed);
+        xOctaveInit(&self->noise, &xr, octaves, amp, omin, len, -1);
+        free(amp);
+    } else {
+        uint64_t rnd;
+        setSeed(&rnd, seed);
+        octaveInit(&self->noise, &rnd, octaves, omin, len);
+    }
+
+    free(self->octaves);
+    self->octaves = octaves;
+    Py_RETURN_NONE;
+}
+
+static PyObject *OctaveNoise_sample(OctaveNoiseObject *self, PyObject *args) {
+    return noise_sample(octave_sampler, &self->noise, args);
+}
+
+static PyObject *OctaveNoise_sample_grid(OctaveNoiseObject *self, PyObject *args, PyObject *kwds) {
+    return noise_sample_grid(octave_sampler, &self->noise, &self->busy, args, kwds);
+}
+
+static PyObject *OctaveNoise_sample_points(OctaveNoiseObject *self, PyObject *args, PyObject *kwds) {
+    return noise_sample_points(octave_sampler, &self->noise, &self->busy, args, kwds);
+}
+
 static PyMemberDef OctaveNoise_members[] = {
-    {"oct_count", T_INT, offsetof(OctaveNoiseObject, noise.octcnt), 0, "octave count"},
+    {"oct_count", T_INT, offsetof(OctaveNoiseObject, noise.octcnt), READONLY, "octave count"},
     {NULL}  /* Sentinel */
 };
 
 static PyMethodDef OctaveNoise_methods[] = {
+    {"init", (PyCFunction) OctaveNoise_init_noise, METH_VARARGS | METH_KEYWORDS, "Seeds length octaves from 2**omin, from a Java Random seed or, with xoroshiro=True, a Xoroshiro seed and optional per-octave amplitudes"},
+    {"sample", (PyCFunction) OctaveNoise_sample, METH_VARARGS, "Samples the noise at (x, y, z)"},
+    {"sample_grid", (PyCFunction) OctaveNoise_sample_grid, METH_VARARGS | METH_KEYWORDS, "Samples an nx x ny x nz grid from (x0, y0, z0) with the given step as a float64 Array of shape (ny * nz, nx)"},
+    {"sample_points", (PyCFunction) OctaveNoise_sample_points, METH_VARARGS | METH_KEYWORDS, "Samples the points given by three float64 buffers xs, ys and zs as a float64 Array"},
     {NULL}  /* Sentinel */
 };
 
@@ -111,24 +457,92 @@ PyTypeObject OctaveNoiseType = {
 typedef struct {
     PyObject_HEAD
     DoublePerlinNoise noise;
+    PerlinNoise *octaves;   // owned storage for both octave sets
+    int busy;
 } DoublePerlinNoiseObject;
 
 static int DoublePerlinNoise_init(DoublePerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    if (noise_check_idle(self->busy) < 0) {
+        return -1;
+    }
+    free(self->octaves);
+    self->octaves = NULL;
     self->noise = (DoublePerlinNoise){0};
     return 0;
 }
 
 static void DoublePerlinNoise_dealloc(DoublePerlinNoiseObject *self) {
-    PyObject_GC_UnTrack(self);
+    free(self->octaves);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
+static double double_perlin_sampler(const void *noise, double x, double y, double z) {
+    return sampleDoublePerlin((const DoublePerlinNoise *)noise, x, y, z);
+}
+
+static PyObject *DoublePerlinNoise_init_noise(DoublePerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"seed", "omin", "length", "xoroshiro", "amplitudes", NULL};
+
+    uint64_t seed;
+    int omin, len;
+    int xoroshiro = 0;
+    PyObject *amplitudes = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Kii|$pO", kwlist, &seed, &omin, &len, &xoroshiro, &amplitudes)) {
+        return NULL;
+    }
+    if (noise_check_idle(self->busy) < 0 || noise_check_octaves(omin, len, xoroshiro, amplitudes) < 0) {
+        return NULL;
+    }
+
+    PerlinNoise *octaves = (PerlinNoise *)calloc(2 * len, sizeof(PerlinNoise));
+    if (!octaves) {
+        return PyErr_NoMemory();
+    }
+
+    if (xoroshiro) {
+        double *amp = noise_amplitudes(amplitudes, len);
+        if (!amp) {
+            free(octaves);
+            return NULL;
+        }
+        Xoroshiro xr;
+        xSetSeed(&xr, seed);
+        xDoublePerlinInit(&self->noise, &xr, octaves, amp, omin, len, -1);
+        free(amp);
+    } else {
+        uint64_t rnd;
+        setSeed(&rnd, seed);
+        doublePerlinInit(&self->noise, &rnd, octaves, octaves + len, omin, len);
+    }
+
+    free(self->octaves);
+    self->octaves = octaves;
+    Py_RETURN_NONE;
+}
+
+static PyObject *DoublePerlinNoise_sample(DoublePerlinNoiseObject *self, PyObject *args) {
+    return noise_sample(double_perlin_sampler, &self->noise, args);
+}
+
+static PyObject *DoublePerlinNoise_sample_grid(DoublePerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    return noise_sample_grid(double_perlin_sampler, &self->noise, &self->busy, args, kwds);
+}
+
+static PyObject *DoublePerlinNoise_sample_points(DoublePerlinNoiseObject *self, PyObject *args, PyObject *kwds) {
+    return noise_sample_points(double_perlin_sampler, &self->noise, &self->busy, args, kwds);
+}
+
 static PyMemberDef DoublePerlinNoise_members[] = {
     {"amplitude", T_DOUBLE, offsetof(DoublePerlinNoiseObject, noise.amplitude), 0, "amplitude value"},
     {NULL}  /* Sentinel */
 };
 
 static PyMethodDef DoublePerlinNoise_methods[] = {
+    {"init", (PyCFunction) DoublePerlinNoise_init_noise, METH_VARARGS | METH_KEYWORDS, "Seeds two sets of length octaves from 2**omin, from a Java Random seed or, with xoroshiro=True, a Xoroshiro seed and optional per-octave amplitudes"},
+    {"sample", (PyCFunction) DoublePerlinNoise_sample, METH_VARARGS, "Samples the noise at (x, y, z)"},
+    {"sample_grid", (PyCFunction) DoublePerlinNoise_sample_grid, METH_VARARGS | METH_KEYWORDS, "Samples an nx x ny x nz grid from (x0, y0, z0) with the given step as a float64 Array of shape (ny * nz, nx)"},
+    {"sample_points", (PyCFunction) DoublePerlinNoise_sample_points, METH_VARARGS | METH_KEYWORDS, "Samples the points given by three float64 buffers xs, ys and zs as a float64 Array"},
     {NULL}  /* Sentinel */
 };
 
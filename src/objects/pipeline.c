@@ -0,0 +1,648 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#include "../external/cubiomes/finders.h"
+
+/*
+ * Pipeline runs a declared set of filter stages over a range of structure
+ * seeds. Stages on the lower 48 bits (structure position, variant rolls) run
+ * first; only their survivors are expanded to the 65536 world seeds that the
+ * world stages (climate, biome, viability, spawn) are evaluated on.
+ *
+ * Within each tier stages are ordered by cost / (1 - pass rate), using the
+ * pass rates measured by earlier runs once there are any. Climate stages
+ * always lead the world tier: they only need the noise of one parameter, so
+ * applySeed is skipped for seeds they reject.
+ */
+
+enum {
+    STAGE_STRUCTURE,
+    STAGE_VARIANT,
+    STAGE_WORLD,
+};
+
+#define VARIANT_FIELD_MAX 16
+
+// StructureVariant fields a variant stage can match. The flags are
+// bit-fields upstream, so fields are read by value, never by offset.
+enum {
+    VF_ABANDONED, VF_GIANT, VF_UNDERGROUND, VF_AIRPOCKET, VF_BASEMENT, VF_CRACKED,
+    VF_SIZE, VF_START, VF_ROTATION, VF_MIRROR,
+};
+
+typedef struct {
+    const char *name;
+    int field;
+    int max;
+} VariantField;
+
+static const VariantField variant_fields[] = {
+    {"abandoned", VF_ABANDONED, 1},
+    {"giant", VF_GIANT, 1},
+    {"underground", VF_UNDERGROUND, 1},
+    {"airpocket", VF_AIRPOCKET, 1},
+    {"basement", VF_BASEMENT, 1},
+    {"cracked", VF_CRACKED, 1},
+    {"size", VF_SIZE, UINT8_MAX},
+    {"start", VF_START, UINT8_MAX},
+    {"rotation", VF_ROTATION, UINT8_MAX},
+    {"mirror", VF_MIRROR, UINT8_MAX},
+    {NULL, 0, 0}
+};
+
+static int variant_field_value(const StructureVariant *sv, int field) {
+    switch (field) {
+    case VF_ABANDONED: return sv->abandoned;
+    case VF_GIANT: return sv->giant;
+    case VF_UNDERGROUND: return sv->underground;
+    case VF_AIRPOCKET: return sv->airpocket;
+    case VF_BASEMENT: return sv->basement;
+    case VF_CRACKED: return sv->cracked;
+    case VF_SIZE: return sv->size;
+    case VF_START: return sv->start;
+    case VF_ROTATION: return sv->rotation;
+    case VF_MIRROR: return sv->mirror;
+    }
+    return -1;
+}
+
+typedef struct {
+    int kind;
+    int structure;
+    int reg_x, reg_z;
+    int x_min, z_min, x_max, z_max;
+    int biome;
+    int field_count;
+    int fields[VARIANT_FIELD_MAX];
+    int field_values[VARIANT_FIELD_MAX];
+    SeedCheck check;
+    uint64_t evaluated;
+    uint64_t passed;
+} PipelineStage;
+
+typedef struct {
+    PyObject_HEAD
+    int version;
+    uint32_t flags;
+    int dim;
+    PipelineStage *stages;
+    int stage_count;
+    int running;
+} PipelineObject;
+
+static void Pipeline_dealloc(PipelineObject *self) {
+    free(self->stages);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *Pipeline_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    PipelineObject *self;
+    self = (PipelineObject *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->stages = NULL;
+        self->stage_count = 0;
+        self->dim = DIM_OVERWORLD;
+    }
+    return (PyObject *)self;
+}
+
+// The stages are used without the GIL while a run is in progress.
+static int Pipeline_check_idle(PipelineObject *self) {
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "Pipeline is running");
+        return -1;
+    }
+    return 0;
+}
+
+static int Pipeline_init(PipelineObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"version", "flags", "dim", NULL};
+
+    int version;
+    uint32_t flags = 0;
+    int dim = DIM_OVERWORLD;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|Ii", kwlist, &version, &flags, &dim)) {
+        return -1;
+    }
+
+    if (Pipeline_check_idle(self) < 0) {
+        return -1;
+    }
+
+    self->version = version;
+    self->flags = flags;
+    self->dim = dim;
+    free(self->stages);
+    self->stages = NULL;
+    self->stage_count = 0;
+
+    return 0;
+}
+
+static PipelineStage *Pipeline_push_stage(PipelineObject *self, int kind) {
+    if (Pipeline_check_idle(self) < 0) {
+        return NULL;
+    }
+
+    PipelineStage *stages = (PipelineStage *)realloc(self->stages, (self->stage_count + 1) * sizeof(PipelineStage));
+    if (!stages) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    self->stages = stages;
+
+    PipelineStage *stage = &stages[self->stage_count++];
+    memset(stage, 0, sizeof(*stage));
+    stage->kind = kind;
+    return stage;
+}
+
+static const char *stage_name(const PipelineStage *stage) {
+    switch (stage->kind) {
+        case STAGE_STRUCTURE: return "structure";
+        case STAGE_VARIANT: return "variant";
+    }
+    switch (stage->check.kind) {
+        case CHECK_VIABLE: return "viable";
+        case CHECK_BIOME: return "biome";
+        case CHECK_SPAWN: return "spawn";
+        case CHECK_CLIMATE: return "climate";
+    }
+    return "unknown";
+}
+
+// Stage costs relative to a single getStructurePos call. World stages also
+// pay for applySeed, which is shared by all of them and not counted here.
+static double stage_cost(const PipelineStage *stage) {
+    switch (stage->kind) {
+        case STAGE_STRUCTURE: return 1.0;
+        case STAGE_VARIANT: return 3.0;
+    }
+    return seed_check_cost(&stage->check);
+}
+
+static double stage_rank(const PipelineStage *stage) {
+    double pass_rate = stage->evaluated ? (double)stage->passed / stage->evaluated : 0.5;
+    double reject_rate = 1.0 - pass_rate;
+    return stage_cost(stage) / (reject_rate > 1e-6 ? reject_rate : 1e-6);
+}
+
+static PyObject *Pipeline_add_structure(PipelineObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"structure", "reg_x", "reg_z", "box", NULL};
+
+    int structure, reg_x, reg_z;
+    int x_min = INT_MIN, z_min = INT_MIN, x_max = INT_MAX, z_max = INT_MAX;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "iii|(iiii)", kwlist, &structure, &reg_x, &reg_z,
+            &x_min, &z_min, &x_max, &z_max)) {
+        return NULL;
+    }
+
+    StructureConfig sc;
+    if (!getStructureConfig(structure, self->version, &sc)) {
+        PyErr_SetString(PyExc_ValueError, "Structure is not supported by this version");
+        return NULL;
+    }
+
+    PipelineStage *stage = Pipeline_push_stage(self, STAGE_STRUCTURE);
+    if (!stage) {
+        return NULL;
+    }
+    stage->structure = structure;
+    stage->reg_x = reg_x;
+    stage->reg_z = reg_z;
+    stage->x_min = x_min;
+    stage->z_min = z_min;
+    stage->x_max = x_max;
+    stage->z_max = z_max;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *Pipeline_add_variant(PipelineObject *self, PyObject *args, PyObject *kwds) {
+    int structure, reg_x, reg_z, biome;
+
+    if (!PyArg_ParseTuple(args, "iiii", &structure, &reg_x, &reg_z, &biome)) {
+        return NULL;
+    }
+
+    PipelineStage stage = {0};
+    stage.kind = STAGE_VARIANT;
+    stage.structure = structure;
+    stage.reg_x = reg_x;
+    stage.reg_z = reg_z;
+    stage.biome = biome;
+
+    // The keyword arguments name the StructureVariant fields to match.
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while (kwds && PyDict_Next(kwds, &pos, &key, &value)) {
+        const char *name = PyUnicode_AsUTF8(key);
+        if (!name) {
+            return NULL;
+        }
+
+        const VariantField *field = variant_fields;
+        while (field->name && strcmp(field->name, name) != 0) {
+            field++;
+        }
+        if (!field->name) {
+            PyErr_Format(PyExc_TypeError, "Unknown variant field '%s'", name);
+            return NULL;
+        }
+        if (stage.field_count == VARIANT_FIELD_MAX) {
+            PyErr_SetString(PyExc_ValueError, "Too many variant fields");
+            return NULL;
+        }
+
+        long v = PyLong_AsLong(value);
+        if (v == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        // Values the field cannot hold could never match.
+        if (v < 0 || v > field->max) {
+            PyErr_Format(PyExc_ValueError, "Variant field '%s' must be between 0 and %d", name, field->max);
+            return NULL;
+        }
+        stage.fields[stage.field_count] = field->field;
+        stage.field_values[stage.field_count] = (int)v;
+        stage.field_count++;
+    }
+
+    PipelineStage *slot = Pipeline_push_stage(self, STAGE_VARIANT);
+    if (!slot) {
+        return NULL;
+    }
+    *slot = stage;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *Pipeline_push_check(PipelineObject *self, PyObject *check_tuple) {
+    if (!check_tuple) {
+        return NULL;
+    }
+
+    SeedCheck check;
+    int err = parse_seed_check(check_tuple, &check);
+    Py_DECREF(check_tuple);
+    if (err < 0) {
+        return NULL;
+    }
+
+    PipelineStage *stage = Pipeline_push_stage(self, STAGE_WORLD);
+    if (!stage) {
+        return NULL;
+    }
+    stage->check = check;
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *Pipeline_add_biome(PipelineObject *self, PyObject *args) {
+    int scale, x, y, z, biome;
+
+    if (!PyArg_ParseTuple(args, "iiiii", &scale, &x, &y, &z, &biome)) {
+        return NULL;
+    }
+    return Pipeline_push_check(self, Py_BuildValue("(siiiii)", "biome", scale, x, y, z, biome));
+}
+
+static PyObject *Pipeline_add_climate(PipelineObject *self, PyObject *args) {
+    int param, x, z;
+    double lo, hi;
+
+    if (!PyArg_ParseTuple(args, "iiidd", &param, &x, &z, &lo, &hi)) {
+        return NULL;
+    }
+    if (self->version < MC_1_18 || self->dim != DIM_OVERWORLD) {
+        PyErr_SetString(PyExc_ValueError, "Climate stages require a 1.18+ Overworld pipeline");
+        return NULL;
+    }
+    return Pipeline_push_check(self, Py_BuildValue("(siiidd)", "climate", param, x, z, lo, hi));
+}
+
+static PyObject *Pipeline_add_viable(PipelineObject *self, PyObject *args) {
+    int structure, x, z;
+    uint32_t flags = 0;
+
+    if (!PyArg_ParseTuple(args, "iii|I", &structure, &x, &z, &flags)) {
+        return NULL;
+    }
+    return Pipeline_push_check(self, Py_BuildValue("(siiiI)", "viable", structure, x, z, flags));
+}
+
+static PyObject *Pipeline_add_spawn(PipelineObject *self, PyObject *args) {
+    int x, z, radius;
+
+    if (!PyArg_ParseTuple(args, "iii", &x, &z, &radius)) {
+        return NULL;
+    }
+    return Pipeline_push_check(self, Py_BuildValue("(siii)", "spawn", x, z, radius));
+}
+
+typedef struct {
+    int version;
+    int dim;
+    const PipelineStage *stages;
+    int stage_count;
+    const int *lower;          // stage indices on the lower 48 bits, in order
+    int lower_count;
+    const int *world;          // stage indices on full world seeds, in order
+    int world_count;
+    int large;
+    BiomeNoise *noises;        // climate scratch, one per thread
+    uint64_t *counters;        // evaluated/passed per thread and stage
+    ResultBuf *results;
+} PipelineRun;
+
+static int pipeline_stage_pass(const PipelineRun *run, const PipelineStage *stage, uint64_t s48) {
+    Pos p;
+    StructureVariant sv;
+
+    if (!getStructurePos(stage->structure, run->version, s48, stage->reg_x, stage->reg_z, &p)) {
+        return 0;
+    }
+
+    if (stage->kind == STAGE_STRUCTURE) {
+        return p.x >= stage->x_min && p.x <= stage->x_max && p.z >= stage->z_min && p.z <= stage->z_max;
+    }
+
+    if (!getVariant(&sv, stage->structure, run->version, s48, p.x, p.z, stage->biome)) {
+        return 0;
+    }
+    for (int i = 0; i < stage->field_count; i++) {
+        if (variant_field_value(&sv, stage->fields[i]) != stage->field_values[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void pipeline_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    PipelineRun *run = (PipelineRun *)arg;
+    Generator *g = pool_generator(tid);
+    uint64_t *counters = run->counters + (size_t)tid * run->stage_count * 2;
+
+    for (uint64_t s48 = lo; s48 < hi; s48++) {
+        int ok = 1;
+        for (int i = 0; i < run->lower_count && ok; i++) {
+            int idx = run->lower[i];
+            counters[2*idx]++;
+            ok = pipeline_stage_pass(run, &run->stages[idx], s48);
+            counters[2*idx+1] += ok;
+        }
+        if (!ok) {
+            continue;
+        }
+
+        if (run->world_count == 0) {
+            resultbuf_push(&run->results[tid], &s48);
+            continue;
+        }
+
+        for (uint64_t upper16 = 0; upper16 < 0x10000; upper16++) {
+            uint64_t seed = (upper16 << 48) | s48;
+            int seeded = 0;
+            int param = -1;
+
+            ok = 1;
+            for (int i = 0; i < run->world_count && ok; i++) {
+                int idx = run->world[i];
+                const SeedCheck *check = &run->stages[idx].check;
+                counters[2*idx]++;
+                if (check->kind == CHECK_CLIMATE) {
+                    // setClimateParaSeed reuses the same octaves for every
+                    // parameter, so only the last one seeded is valid.
+                    BiomeNoise *bn = &run->noises[tid];
+                    if (param != check->param) {
+                        setClimateParaSeed(bn, seed, run->large, check->param, -1);
+                        param = check->param;
+                    }
+                    ok = climate_check_pass(check, &bn->climate[param]);
+                } else {
+                    if (!seeded) {
+                        applySeed(g, run->dim, seed);
+                        seeded = 1;
+                    }
+                    ok = seed_check_pass(check, g);
+                }
+                counters[2*idx+1] += ok;
+            }
+            if (ok) {
+                resultbuf_push(&run->results[tid], &seed);
+            }
+        }
+    }
+}
+
+static const PipelineStage *sort_stages_base;
+
+static int stage_is_climate(const PipelineStage *stage) {
+    return stage->kind == STAGE_WORLD && stage->check.kind == CHECK_CLIMATE;
+}
+
+static int compare_stage_rank(const void *a, const void *b) {
+    int ca = stage_is_climate(&sort_stages_base[*(const int *)a]);
+    int cb = stage_is_climate(&sort_stages_base[*(const int *)b]);
+    if (ca != cb) {
+        return cb - ca;
+    }
+
+    double x = stage_rank(&sort_stages_base[*(const int *)a]);
+    double y = stage_rank(&sort_stages_base[*(const int *)b]);
+    return (x > y) - (x < y);
+}
+
+// Splits the stages into the two tiers and orders each by rank.
+static void Pipeline_order(PipelineObject *self, int *lower, int *lower_count, int *world, int *world_count) {
+    *lower_count = *world_count = 0;
+    for (int i = 0; i < self->stage_count; i++) {
+        if (self->stages[i].kind == STAGE_WORLD) {
+            world[(*world_count)++] = i;
+        } else {
+            lower[(*lower_count)++] = i;
+        }
+    }
+
+    // Called with the GIL held, which serialises use of sort_stages_base.
+    sort_stages_base = self->stages;
+    qsort(lower, *lower_count, sizeof(int), compare_stage_rank);
+    qsort(world, *world_count, sizeof(int), compare_stage_rank);
+}
+
+static PyObject *Pipeline_run(PipelineObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"lo", "hi", "threads", NULL};
+
+    uint64_t lo, hi;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "KK|i", kwlist, &lo, &hi, &threads)) {
+        return NULL;
+    }
+
+    if (lo > hi || hi > (1ULL << 48)) {
+        PyErr_SetString(PyExc_ValueError, "Seed range must satisfy 0 <= lo <= hi <= 2**48");
+        return NULL;
+    }
+
+    if (Pipeline_check_idle(self) < 0) {
+        return NULL;
+    }
+
+    PipelineRun run = {0};
+    int n = self->stage_count;
+    threads = resolve_thread_count(threads);
+
+    int *order = (int *)malloc((2 * n + 1) * sizeof(int));
+    run.noises = (BiomeNoise *)malloc(threads * sizeof(BiomeNoise));
+    run.counters = (uint64_t *)calloc((size_t)threads * n * 2 + 1, sizeof(uint64_t));
+    run.results = (ResultBuf *)malloc(threads * sizeof(ResultBuf));
+    if (!order || !run.noises || !run.counters || !run.results) {
+        free(order);
+        free(run.noises);
+        free(run.counters);
+        free(run.results);
+        return PyErr_NoMemory();
+    }
+
+    int lower_count, world_count;
+    Pipeline_order(self, order, &lower_count, order + n, &world_count);
+
+    run.version = self->version;
+    run.dim = self->dim;
+    run.large = (self->flags & LARGE_BIOMES) != 0;
+    run.stages = self->stages;
+    run.stage_count = n;
+    run.lower = order;
+    run.lower_count = lower_count;
+    run.world = order + n;
+    run.world_count = world_count;
+
+    uint64_t *seeds = NULL;
+    size_t len;
+    int failed = 1;
+
+    self->running = 1;
+    Py_BEGIN_ALLOW_THREADS
+    threads = pool_begin(threads);
+    // Only world stages need the pool generators.
+    if (!world_count || pool_generators(threads, self->version, self->flags) == 0) {
+        for (int i = 0; i < threads; i++) {
+            resultbuf_init(&run.results[i], sizeof(uint64_t));
+        }
+
+        // Expanding a survivor costs 65536 seed applications, so hand out
+        // small chunks when there are world stages.
+        pool_run(lo, hi, world_count ? 16 : 1 << 16, threads, pipeline_worker, &run);
+        seeds = (uint64_t *)resultbuf_merge(run.results, threads, &len, &failed);
+    }
+    pool_end();
+    if (seeds) {
+        qsort(seeds, len, sizeof(uint64_t), compare_u64);
+    }
+    Py_END_ALLOW_THREADS
+    self->running = 0;
+
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < n; i++) {
+            self->stages[i].evaluated += run.counters[((size_t)t * n + i) * 2];
+            self->stages[i].passed += run.counters[((size_t)t * n + i) * 2 + 1];
+        }
+    }
+
+    free(order);
+    free(run.noises);
+    free(run.counters);
+    free(run.results);
+
+    if (failed) {
+        free(seeds);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)Array_from_data(seeds, 'Q', sizeof(uint64_t), len, 0);
+}
+
+static PyObject *Pipeline_get_stats(PipelineObject *self, void *closure) {
+    int n = self->stage_count;
+    int *order = (int *)malloc((2 * n + 1) * sizeof(int));
+    if (!order) {
+        return PyErr_NoMemory();
+    }
+
+    int lower_count, world_count;
+    Pipeline_order(self, order, &lower_count, order + n, &world_count);
+    memmove(order + lower_count, order + n, world_count * sizeof(int));
+
+    PyObject *list = PyList_New(n);
+    if (!list) {
+        free(order);
+        return NULL;
+    }
+
+    for (int i = 0; i < n; i++) {
+        const PipelineStage *stage = &self->stages[order[i]];
+        PyObject *dict = Py_BuildValue("{s:s,s:K,s:K}",
+            "stage", stage_name(stage),
+            "evaluated", (unsigned long long)stage->evaluated,
+            "passed", (unsigned long long)stage->passed);
+        if (!dict) {
+            Py_DECREF(list);
+            free(order);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, dict);
+    }
+
+    free(order);
+    return list;
+}
+
+static PyObject *Pipeline_reset_stats(PipelineObject *self, PyObject *Py_UNUSED(args)) {
+    if (Pipeline_check_idle(self) < 0) {
+        return NULL;
+    }
+    for (int i = 0; i < self->stage_count; i++) {
+        self->stages[i].evaluated = 0;
+        self->stages[i].passed = 0;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef Pipeline_methods[] = {
+    {"add_structure", (PyCFunction)Pipeline_add_structure, METH_VARARGS | METH_KEYWORDS, "Requires the structure attempt in a region to lie in box (x0, z0, x1, z1)"},
+    {"add_variant", (PyCFunction)Pipeline_add_variant, METH_VARARGS | METH_KEYWORDS, "Requires the structure variant in a region to match the given fields, e.g. rotation=1"},
+    {"add_biome", (PyCFunction)Pipeline_add_biome, METH_VARARGS, "Requires the biome at a point"},
+    {"add_climate", (PyCFunction)Pipeline_add_climate, METH_VARARGS, "Requires a climate parameter's noise at 1:4 x, z to lie in [lo, hi] (1.18+)"},
+    {"add_viable", (PyCFunction)Pipeline_add_viable, METH_VARARGS, "Requires a structure position to be viable"},
+    {"add_spawn", (PyCFunction)Pipeline_add_spawn, METH_VARARGS, "Requires the world spawn within radius blocks of a point"},
+    {"run", (PyCFunction)Pipeline_run, METH_VARARGS | METH_KEYWORDS, "Runs the pipeline over the structure seeds in [lo, hi), returning the surviving seeds"},
+    {"reset_stats", (PyCFunction)Pipeline_reset_stats, METH_NOARGS, "Clears the per-stage counters"},
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef Pipeline_getsets[] = {
+    {"stats", (getter)Pipeline_get_stats, NULL, "Per-stage evaluated/passed counters, in execution order", NULL},
+    {NULL, 0, NULL, NULL, NULL} /* Sentinel */
+};
+
+static PyTypeObject PipelineType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.Pipeline",
+    .tp_doc = "Compiled seed filter pipeline",
+    .tp_basicsize = sizeof(PipelineObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = Pipeline_new,
+    .tp_init = (initproc) Pipeline_init,
+    .tp_dealloc = (destructor) Pipeline_dealloc,
+    .tp_methods = Pipeline_methods,
+    .tp_getset = Pipeline_getsets,
+};
@@ -0,0 +1,386 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#include "../external/cubiomes/quadbase.h"
+
+/*
+ * QuadSearch finds quad structure bases (four structures whose regions meet
+ * at a corner, close enough together) natively across threads.
+ *
+ * The search walks an index space. Without low bits every 48-bit seed is a
+ * candidate; with one of the quadbase.c low 20 bit lists, candidate i is
+ * ((i / n) << 20) | low[i % n], which skips the seeds that cannot form the
+ * constellation. The lists are only valid for the hut region layout, where
+ * "barely" is the default; other structures scan every seed. Each
+ * candidate is checked with isQuadBase and the hits are yielded as
+ * (base, (p00, p10, p01, p11)) with the positions in regions (0, 0),
+ * (1, 0), (0, 1) and (1, 1).
+ *
+ * The index space is scanned a chunk at a time and `position` is the first
+ * index not yet fully yielded, so a search can be resumed by passing it as
+ * lo to a new QuadSearch.
+ */
+
+#define QUAD_INDEX_BITS 48
+
+typedef struct {
+    uint64_t base;
+    float radius;
+} QuadHit;
+
+typedef struct {
+    PyObject_HEAD
+    int version;
+    StructureConfig sc;
+    const uint64_t *low;
+    int low_count;
+    int radius;
+    int threads;
+    uint64_t chunk;
+    uint64_t next;      // first index not yet scanned
+    uint64_t hi;
+    uint64_t position;  // first index whose hits are not all yielded
+    QuadHit *hits;      // hits of the last chunk
+    size_t hit_count;
+    size_t hit_pos;
+    int running;
+} QuadSearchObject;
+
+typedef struct {
+    const char *name;
+    const uint64_t *bits;
+    int count;
+} LowBitList;
+
+static const LowBitList quad_low_bits[] = {
+    {"ideal", low20QuadIdeal, sizeof(low20QuadIdeal) / sizeof(uint64_t)},
+    {"classic", low20QuadClassic, sizeof(low20QuadClassic) / sizeof(uint64_t)},
+    {"normal", low20QuadHutNormal, sizeof(low20QuadHutNormal) / sizeof(uint64_t)},
+    {"barely", low20QuadHutBarely, sizeof(low20QuadHutBarely) / sizeof(uint64_t)},
+    {NULL, NULL, 0}
+};
+
+static void QuadSearch_dealloc(QuadSearchObject *self) {
+    free(self->hits);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+// Number of candidates in the index space.
+static uint64_t QuadSearch_index_count(const QuadSearchObject *self) {
+    if (!self->low) {
+        return 1ULL << QUAD_INDEX_BITS;
+    }
+    return (uint64_t)self->low_count << (QUAD_INDEX_BITS - 20);
+}
+
+static inline uint64_t quad_candidate(const uint64_t *low, int low_count, uint64_t i) {
+    if (!low) {
+        return i;
+    }
+    return ((i / low_count) << 20) | low[i % low_count];
+}
+
+static int QuadSearch_init(QuadSearchObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"version", "structure", "lo", "hi", "low_bits", "radius", "threads", "chunk", NULL};
+
+    int version, structure;
+    uint64_t lo = 0, hi = UINT64_MAX;
+    PyObject *low_bits = NULL;
+    int radius = 128;
+    int threads = 0;
+    uint64_t chunk = 1 << 20;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii|KK$OiiK", kwlist,
+            &version, &structure, &lo, &hi, &low_bits, &radius, &threads, &chunk)) {
+        return -1;
+    }
+
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "QuadSearch is running");
+        return -1;
+    }
+
+    StructureConfig sc;
+    if (!getStructureConfig(structure, version, &sc)) {
+        PyErr_SetString(PyExc_ValueError, "Structure is not supported by this version");
+        return -1;
+    }
+
+    // The low bit lists only hold for the 32 chunk regions and 24 chunk
+    // range of the huts, so other structures default to every seed.
+    int hut_config = sc.regionSize == 32 && sc.chunkRange == 24;
+    const char *name = NULL;
+    if (!low_bits) {
+        name = hut_config ? "barely" : NULL;
+    } else if (low_bits != Py_None) {
+        name = PyUnicode_AsUTF8(low_bits);
+        if (!name) {
+            return -1;
+        }
+    }
+
+    const uint64_t *low = NULL;
+    int low_count = 0;
+    if (name) {
+        const LowBitList *list = quad_low_bits;
+        while (list->name && strcmp(list->name, name) != 0) {
+            list++;
+        }
+        if (!list->name) {
+            PyErr_Format(PyExc_ValueError, "Unknown low_bits '%s' (expected ideal, classic, normal, barely or None)", name);
+            return -1;
+        }
+        if (!hut_config) {
+            PyErr_SetString(PyExc_ValueError, "low_bits lists only apply to structures with 32 chunk regions and a 24 chunk range; pass low_bits=None");
+            return -1;
+        }
+        low = list->bits;
+        low_count = list->count;
+    }
+
+    self->version = version;
+    self->sc = sc;
+    self->low = low;
+    self->low_count = low_count;
+
+    uint64_t count = QuadSearch_index_count(self);
+    if (hi > count) {
+        hi = count;
+    }
+    if (lo > hi) {
+        PyErr_SetString(PyExc_ValueError, "lo must not exceed hi or the number of candidates");
+        return -1;
+    }
+
+    self->radius = radius;
+    self->threads = threads;
+    self->chunk = chunk ? chunk : 1;
+    self->next = lo;
+    self->hi = hi;
+    self->position = lo;
+    free(self->hits);
+    self->hits = NULL;
+    self->hit_count = 0;
+    self->hit_pos = 0;
+
+    return 0;
+}
+
+typedef struct {
+    StructureConfig sc;
+    const uint64_t *low;
+    int low_count;
+    int radius;
+    ResultBuf *results;
+} QuadScan;
+
+static void quad_scan_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    QuadScan *scan = (QuadScan *)arg;
+
+    for (uint64_t i = lo; i < hi; i++) {
+        // The low bit lists include the structure salt.
+        uint64_t base = (quad_candidate(scan->low, scan->low_count, i) - scan->sc.salt) & 0xffffffffffffULL;
+        float r = isQuadBase(scan->sc, base, scan->radius);
+        if (r) {
+            QuadHit hit = {base, r};
+            resultbuf_push(&scan->results[tid], &hit);
+        }
+    }
+}
+
+static int compare_quad_hit(const void *a, const void *b) {
+    return compare_u64(&((const QuadHit *)a)->base, &((const QuadHit *)b)->base);
+}
+
+/*
+ * Scans chunks until one has hits or the range is exhausted. Returns 0, or
+ * -1 with an exception set.
+ */
+static int QuadSearch_fill(QuadSearchObject *self) {
+    int threads = resolve_thread_count(self->threads);
+    ResultBuf *results = (ResultBuf *)malloc(threads * sizeof(ResultBuf));
+    if (!results) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    QuadScan scan;
+    scan.sc = self->sc;
+    scan.low = self->low;
+    scan.low_count = self->low_count;
+    scan.radius = self->radius;
+    scan.results = results;
+
+    uint64_t start = self->next, lo = start;
+    QuadHit *hits = NULL;
+    size_t len = 0;
+    int failed = 0;
+    int interrupted = 0;
+
+    self->running = 1;
+    while (lo < self->hi) {
+        uint64_t hi = self->hi - lo > self->chunk ? lo + self->chunk : self->hi;
+        int used;
+        start = lo;
+
+        Py_BEGIN_ALLOW_THREADS
+        for (int i = 0; i < threads; i++) {
+            resultbuf_init(&results[i], sizeof(QuadHit));
+        }
+        used = parallel_range(lo, hi, 1024, threads, quad_scan_worker, &scan);
+        hits = (QuadHit *)resultbuf_merge(results, used, &len, &failed);
+        if (len) {
+            qsort(hits, len, sizeof(QuadHit), compare_quad_hit);
+        }
+        Py_END_ALLOW_THREADS
+
+        if (failed) {
+            break;
+        }
+        lo = hi;
+        if (len) {
+            break;
+        }
+        free(hits);
+        hits = NULL;
+
+        // Long stretches without hits stay interruptible; the chunks done
+        // so far are kept.
+        if (PyErr_CheckSignals() < 0) {
+            interrupted = 1;
+            break;
+        }
+    }
+    self->running = 0;
+    free(results);
+
+    if (failed) {
+        free(hits);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    free(self->hits);
+    self->hits = hits;
+    self->hit_count = len;
+    self->hit_pos = 0;
+    // Chunks without hits are complete; the one with hits completes once
+    // all of them are yielded.
+    self->position = len ? start : lo;
+    self->next = lo;
+    return interrupted ? -1 : 0;
+}
+
+static PyObject *QuadSearch_iter(QuadSearchObject *self) {
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *QuadSearch_next(QuadSearchObject *self) {
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "QuadSearch is running");
+        return NULL;
+    }
+
+    static const int regions[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+    const QuadHit *hit;
+    Pos p[4];
+    int found;
+    do {
+        if (self->hit_pos == self->hit_count) {
+            self->position = self->next;
+            if (self->next >= self->hi) {
+                return NULL;
+            }
+            if (QuadSearch_fill(self) < 0) {
+                return NULL;
+            }
+            if (self->hit_count == 0) {
+                return NULL;
+            }
+        }
+
+        hit = &self->hits[self->hit_pos++];
+        if (self->hit_pos == self->hit_count) {
+            self->position = self->next;
+        }
+
+        // A base whose structures cannot all be placed is not a quad.
+        found = 1;
+        for (int i = 0; i < 4 && found; i++) {
+            found = getStructurePos(self->sc.structType, self->version, hit->base, regions[i][0], regions[i][1], &p[i]);
+        }
+    } while (!found);
+
+    PyObject *positions = PyTuple_New(4);
+    if (!positions) {
+        return NULL;
+    }
+    for (int i = 0; i < 4; i++) {
+        PosObject *pos = (PosObject *)Pos_new(&PosType, NULL, NULL);
+        if (!pos) {
+            Py_DECREF(positions);
+            return NULL;
+        }
+        pos->pos = p[i];
+        PyTuple_SET_ITEM(positions, i, (PyObject *)pos);
+    }
+
+    return Py_BuildValue("(KN)", (unsigned long long)hit->base, positions);
+}
+
+static PyObject *QuadSearch_move(QuadSearchObject *self, PyObject *args) {
+    uint64_t base;
+    int reg_x, reg_z;
+
+    if (!PyArg_ParseTuple(args, "Kii", &base, &reg_x, &reg_z)) {
+        return NULL;
+    }
+    return PyLong_FromUnsignedLongLong(moveStructure(base, reg_x, reg_z));
+}
+
+static PyObject *QuadSearch_get_position(QuadSearchObject *self, void *closure) {
+    return PyLong_FromUnsignedLongLong(self->position);
+}
+
+static PyObject *QuadSearch_get_count(QuadSearchObject *self, void *closure) {
+    return PyLong_FromUnsignedLongLong(QuadSearch_index_count(self));
+}
+
+static PyMethodDef QuadSearch_methods[] = {
+    {"move", (PyCFunction) QuadSearch_move, METH_VARARGS | METH_STATIC, "Translates a base seed so its quad lies at regions (reg_x, reg_z) to (reg_x+1, reg_z+1)"},
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef QuadSearch_getsets[] = {
+    {"position", (getter)QuadSearch_get_position, NULL, "First candidate index whose hits have not all been yielded; pass as lo to resume", NULL},
+    {"count", (getter)QuadSearch_get_count, NULL, "Number of candidate indices in the search space", NULL},
+    {NULL, 0, NULL, NULL, NULL} /* Sentinel */
+};
+
+static PyMemberDef QuadSearch_members[] = {
+    {"hi", T_ULONGLONG, offsetof(QuadSearchObject, hi), READONLY, "End of the candidate index range"},
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject QuadSearchType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.QuadSearch",
+    .tp_doc = "Native, resumable search for quad structure bases",
+    .tp_basicsize = sizeof(QuadSearchObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) QuadSearch_init,
+    .tp_dealloc = (destructor) QuadSearch_dealloc,
+    .tp_iter = (getiterfunc) QuadSearch_iter,
+    .tp_iternext = (iternextfunc) QuadSearch_next,
+    .tp_methods = QuadSearch_methods,
+    .tp_members = QuadSearch_members,
+    .tp_getset = QuadSearch_getsets,
+};
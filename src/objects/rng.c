@@ -74,12 +74,11 @@ static PyObject *Rng_next_long(RngObject *self, PyObject *args) {
     return PyLong_FromLongLong(nextLong(&(self->seed)));
 }
 
-static PyObject *Rng_next_int(RngObject *self, PyObject *args) {
-	int n;
-    if (!PyArg_ParseTuple(args, "i", &n)) {
+static PyObject *Rng_next_int(RngObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int n;
+    if (fastcall_nargs("next_int", nargs, 1) < 0 || fastcall_int(args[0], &n) < 0) {
         return NULL;
     }
-	
     return PyLong_FromLong(nextInt(&(self->seed), n));
 }
 
@@ -91,13 +90,96 @@ static PyObject *Rng_next_double(RngObject *self, PyObject *args) {
     return PyFloat_FromDouble(nextDouble(&(self->seed)));
 }
 
+// Validates the count of a bulk method.
+static int rng_check_count(Py_ssize_t count) {
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "count must not be negative");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *Rng_next_ints(RngObject *self, PyObject *args) {
+    int n;
+    Py_ssize_t count;
+    if (!PyArg_ParseTuple(args, "in", &n, &count) || rng_check_count(count) < 0) {
+        return NULL;
+    }
+    if (n <= 0) {
+        PyErr_SetString(PyExc_ValueError, "n must be positive");
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('i', sizeof(int), count, 0);
+    if (!ret) {
+        return NULL;
+    }
+    int *out = (int *)ret->data;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        out[i] = nextInt(&self->seed, n);
+    }
+    return (PyObject *)ret;
+}
+
+static PyObject *Rng_next_floats(RngObject *self, PyObject *args) {
+    Py_ssize_t count;
+    if (!PyArg_ParseTuple(args, "n", &count) || rng_check_count(count) < 0) {
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('f', sizeof(float), count, 0);
+    if (!ret) {
+        return NULL;
+    }
+    float *out = (float *)ret->data;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        out[i] = nextFloat(&self->seed);
+    }
+    return (PyObject *)ret;
+}
+
+static PyObject *Rng_next_longs(RngObject *self, PyObject *args) {
+    Py_ssize_t count;
+    if (!PyArg_ParseTuple(args, "n", &count) || rng_check_count(count) < 0) {
+        return NULL;
+    }
+
+    // Signed, like next_long.
+    ArrayObject *ret = Array_zeros('q', sizeof(int64_t), count, 0);
+    if (!ret) {
+        return NULL;
+    }
+    int64_t *out = (int64_t *)ret->data;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        out[i] = (int64_t)nextLong(&self->seed);
+    }
+    return (PyObject *)ret;
+}
+
+/*
+ * Advances the seed by n calls to next() in O(log n). The LCG has period
+ * 2**48, so a negative n steps back.
+ */
+static PyObject *Rng_skip(RngObject *self, PyObject *args) {
+    long long n;
+    if (!PyArg_ParseTuple(args, "L", &n)) {
+        return NULL;
+    }
+    skipNextN(&self->seed, (uint64_t)n);
+    Py_RETURN_NONE;
+}
+
 static PyMethodDef Rng_methods[] = {
     {"set_seed", (PyCFunction)Rng_set_seed, METH_VARARGS, "Set the seed value"},
     {"next", (PyCFunction)Rng_next_long, METH_NOARGS, "Call the next() rng function"},
     {"next_long", (PyCFunction)Rng_next_long, METH_NOARGS, "Generate the next long random number"},
-    {"next_int", (PyCFunction)Rng_next_int, METH_VARARGS, "Generate the next int random number up to n"},
+    {"next_int", FASTCALL(Rng_next_int), METH_FASTCALL, "Generate the next int random number up to n"},
     {"next_float", (PyCFunction)Rng_next_float, METH_NOARGS, "Generate the next float random number"},
     {"next_double", (PyCFunction)Rng_next_double, METH_NOARGS, "Generate the next double random number"},
+    {"next_ints", (PyCFunction)Rng_next_ints, METH_VARARGS, "Generates count ints up to n as an int32 array"},
+    {"next_floats", (PyCFunction)Rng_next_floats, METH_VARARGS, "Generates count floats as a float32 array"},
+    {"next_longs", (PyCFunction)Rng_next_longs, METH_VARARGS, "Generates count longs as an int64 array"},
+    {"skip", (PyCFunction)Rng_skip, METH_VARARGS, "Advances the seed by n next() calls in O(log n); negative n steps back"},
     {NULL}  /* Sentinel */
 };
 
@@ -157,9 +239,9 @@ static PyObject *Xoroshiro_next_long(XoroshiroObject *self, PyObject *args) {
     return PyLong_FromUnsignedLongLong(xNextLong(&(self->state)));
 }
 
-static PyObject *Xoroshiro_next_int(XoroshiroObject *self, PyObject *args) {
+static PyObject *Xoroshiro_next_int(XoroshiroObject *self, PyObject *const *args, Py_ssize_t nargs) {
     uint32_t n;
-    if (!PyArg_ParseTuple(args, "I", &n)) {
+    if (fastcall_nargs("next_int", nargs, 1) < 0 || fastcall_u32(args[0], &n) < 0) {
         return NULL;
     }
     return PyLong_FromLong(xNextInt(&(self->state), n));
@@ -177,22 +259,78 @@ static PyObject *Xoroshiro_next_long_j(XoroshiroObject *self, PyObject *args) {
     return PyLong_FromUnsignedLongLong(xNextLongJ(&(self->state)));
 }
 
-static PyObject *Xoroshiro_next_int_j(XoroshiroObject *self, PyObject *args) {
+static PyObject *Xoroshiro_next_int_j(XoroshiroObject *self, PyObject *const *args, Py_ssize_t nargs) {
     uint32_t n;
-    if (!PyArg_ParseTuple(args, "I", &n)) {
+    if (fastcall_nargs("next_int_j", nargs, 1) < 0 || fastcall_u32(args[0], &n) < 0) {
         return NULL;
     }
     return PyLong_FromLong(xNextIntJ(&(self->state), n));
 }
 
+static PyObject *Xoroshiro_next_ints(XoroshiroObject *self, PyObject *args) {
+    uint32_t n;
+    Py_ssize_t count;
+    if (!PyArg_ParseTuple(args, "In", &n, &count) || rng_check_count(count) < 0) {
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('i', sizeof(int), count, 0);
+    if (!ret) {
+        return NULL;
+    }
+    int *out = (int *)ret->data;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        out[i] = xNextInt(&self->state, n);
+    }
+    return (PyObject *)ret;
+}
+
+static PyObject *Xoroshiro_next_floats(XoroshiroObject *self, PyObject *args) {
+    Py_ssize_t count;
+    if (!PyArg_ParseTuple(args, "n", &count) || rng_check_count(count) < 0) {
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('f', sizeof(float), count, 0);
+    if (!ret) {
+        return NULL;
+    }
+    float *out = (float *)ret->data;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        out[i] = xNextFloat(&self->state);
+    }
+    return (PyObject *)ret;
+}
+
+static PyObject *Xoroshiro_next_longs(XoroshiroObject *self, PyObject *args) {
+    Py_ssize_t count;
+    if (!PyArg_ParseTuple(args, "n", &count) || rng_check_count(count) < 0) {
+        return NULL;
+    }
+
+    // Unsigned, like next_long.
+    ArrayObject *ret = Array_zeros('Q', sizeof(uint64_t), count, 0);
+    if (!ret) {
+        return NULL;
+    }
+    uint64_t *out = (uint64_t *)ret->data;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        out[i] = xNextLong(&self->state);
+    }
+    return (PyObject *)ret;
+}
+
 static PyMethodDef Xoroshiro_methods[] = {
     {"set_seed", (PyCFunction)Xoroshiro_set_seed, METH_VARARGS, "Set the seed value"},
     {"next_long", (PyCFunction)Xoroshiro_next_long, METH_NOARGS, "Generate the next long random number"},
-    {"next_int", (PyCFunction)Xoroshiro_next_int, METH_VARARGS, "Generate the next int random number up to n"},
+    {"next_int", FASTCALL(Xoroshiro_next_int), METH_FASTCALL, "Generate the next int random number up to n"},
     {"next_float", (PyCFunction)Xoroshiro_next_float, METH_NOARGS, "Generate the next float random number"},
     {"next_double", (PyCFunction)Xoroshiro_next_double, METH_NOARGS, "Generate the next double random number"},
     {"next_long_j", (PyCFunction)Xoroshiro_next_long_j, METH_NOARGS, "Generate the next long random number from two separate xNextLong calls"},
-    {"next_int_j", (PyCFunction)Xoroshiro_next_int_j, METH_VARARGS, "Generate the next int random number up to n using the worldgenrandom method"},
+    {"next_int_j", FASTCALL(Xoroshiro_next_int_j), METH_FASTCALL, "Generate the next int random number up to n using the worldgenrandom method"},
+    {"next_ints", (PyCFunction)Xoroshiro_next_ints, METH_VARARGS, "Generates count ints up to n as an int32 array"},
+    {"next_floats", (PyCFunction)Xoroshiro_next_floats, METH_VARARGS, "Generates count floats as a float32 array"},
+    {"next_longs", (PyCFunction)Xoroshiro_next_longs, METH_VARARGS, "Generates count longs as a uint64 array"},
     {NULL}  /* Sentinel */
 };
 
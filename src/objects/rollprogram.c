@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#include "../external/cubiomes/finders.h"
+
+/*
+ * RollProgram evaluates a fixed sequence of Java Random rolls on the chunk
+ * seeds of many (lower48, chunk x, chunk z) rows at once, the way structure
+ * variants are decoded, and returns the rows whose rolls all pass:
+ *
+ *   ("int", n[, lo, hi])    nextInt(n), kept if lo <= value <= hi
+ *   ("float"[, lo, hi])     nextFloat(), kept if lo <= value < hi
+ *   ("bool"[, value])       nextBoolean(), kept if equal to value
+ *   ("skip", calls)         advances by calls next() calls, e.g. 2 per nextLong
+ *
+ * Rolls without bounds only advance the seed. Float bounds are compared as
+ * Java floats, like the float literals in the game code.
+ *
+ * Rows are processed in blocks, one roll at a time across the block, with
+ * the rejected rows compacted away after each roll, so later rolls only
+ * step the seeds still in play.
+ */
+
+#define LCG_MUL 0x5deece66dULL
+#define LCG_ADD 0xbULL
+#define LCG_MASK ((1ULL << 48) - 1)
+#define ROLL_BLOCK 256
+
+enum {
+    ROLL_INT,
+    ROLL_FLOAT,
+    ROLL_BOOL,
+    ROLL_SKIP,
+};
+
+typedef struct {
+    int kind;
+    int checked;
+    int n;
+    int lo, hi;         // int bounds, inclusive
+    float flo, fhi;     // float bounds, [flo, fhi)
+    int value;          // bool
+    uint64_t mul, add;  // skip as one affine step
+} Roll;
+
+typedef struct {
+    PyObject_HEAD
+    Roll *rolls;
+    int count;
+    int running;        // run() calls in progress
+} RollProgramObject;
+
+static void RollProgram_dealloc(RollProgramObject *self) {
+    free(self->rolls);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int parse_roll(PyObject *item, Roll *r) {
+    const char *kind;
+
+    if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) < 1 || !PyUnicode_Check(PyTuple_GET_ITEM(item, 0))) {
+        PyErr_SetString(PyExc_TypeError, "Each roll must be a tuple starting with its kind ('int', 'float', 'bool' or 'skip')");
+        return -1;
+    }
+
+    memset(r, 0, sizeof(*r));
+    kind = PyUnicode_AsUTF8(PyTuple_GET_ITEM(item, 0));
+    if (!kind) {
+        return -1;
+    }
+    Py_ssize_t size = PyTuple_GET_SIZE(item);
+
+    if (strcmp(kind, "int") == 0) {
+        r->kind = ROLL_INT;
+        if (size == 3) {
+            PyErr_SetString(PyExc_TypeError, "int roll takes n or n, lo, hi");
+            return -1;
+        }
+        if (!PyArg_ParseTuple(item, "si|ii:int roll", &kind, &r->n, &r->lo, &r->hi)) {
+            return -1;
+        }
+        if (r->n <= 0) {
+            PyErr_SetString(PyExc_ValueError, "int roll bound must be positive");
+            return -1;
+        }
+        r->checked = size == 4;
+        return 0;
+    }
+
+    if (strcmp(kind, "float") == 0) {
+        double lo = 0.0, hi = 1.0;
+        r->kind = ROLL_FLOAT;
+        if (size == 2) {
+            PyErr_SetString(PyExc_TypeError, "float roll takes no bounds or lo, hi");
+            return -1;
+        }
+        if (!PyArg_ParseTuple(item, "s|dd:float roll", &kind, &lo, &hi)) {
+            return -1;
+        }
+        r->flo = (float)lo;
+        r->fhi = (float)hi;
+        r->checked = size == 3;
+        return 0;
+    }
+
+    if (strcmp(kind, "bool") == 0) {
+        r->kind = ROLL_BOOL;
+        if (!PyArg_ParseTuple(item, "s|p:bool roll", &kind, &r->value)) {
+            return -1;
+        }
+        r->checked = size == 2;
+        return 0;
+    }
+
+    if (strcmp(kind, "skip") == 0) {
+        unsigned long long calls;
+        r->kind = ROLL_SKIP;
+        if (!PyArg_ParseTuple(item, "sK:skip roll", &kind, &calls)) {
+            return -1;
+        }
+        // skipNextN applies s * mul + add; recover both from two seeds.
+        uint64_t s0 = 0, s1 = 1;
+        skipNextN(&s0, calls);
+        skipNextN(&s1, calls);
+        r->add = s0;
+        r->mul = (s1 - s0) & LCG_MASK;
+        return 0;
+    }
+
+    PyErr_Format(PyExc_ValueError, "Unknown roll kind '%s'", kind);
+    return -1;
+}
+
+static int RollProgram_init(RollProgramObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"rolls", NULL};
+
+    PyObject *rolls_obj;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &rolls_obj)) {
+        return -1;
+    }
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "RollProgram is running");
+        return -1;
+    }
+
+    PyObject *fast = PySequence_Fast(rolls_obj, "rolls must be a sequence of tuples");
+    if (!fast) {
+        return -1;
+    }
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+    if (n > INT_MAX) {
+        Py_DECREF(fast);
+        PyErr_SetString(PyExc_ValueError, "Too many rolls");
+        return -1;
+    }
+    Roll *rolls = (Roll *)malloc((n ? n : 1) * sizeof(Roll));
+    if (!rolls) {
+        Py_DECREF(fast);
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (parse_roll(PySequence_Fast_GET_ITEM(fast, i), &rolls[i]) < 0) {
+            free(rolls);
+            Py_DECREF(fast);
+            return -1;
+        }
+    }
+    Py_DECREF(fast);
+
+    free(self->rolls);
+    self->rolls = rolls;
+    self->count = (int)n;
+    return 0;
+}
+
+/*
+ * Applies one roll to the live rows of a block, compacting the rows that
+ * pass to the front. Returns the number of rows left.
+ */
+static int roll_apply(const Roll *r, uint64_t *state, int64_t *rows, int live) {
+    int kept = 0;
+
+    switch (r->kind) {
+        case ROLL_SKIP:
+            for (int i = 0; i < live; i++) {
+                state[i] = (state[i] * r->mul + r->add) & LCG_MASK;
+            }
+            return live;
+
+        case ROLL_FLOAT:
+            for (int i = 0; i < live; i++) {
+                uint64_t s = (state[i] * LCG_MUL + LCG_ADD) & LCG_MASK;
+                float f = (int)(s >> 24) / (float)(1 << 24);
+                state[kept] = s;
+                rows[kept] = rows[i];
+                kept += !r->checked || (f >= r->flo && f < r->fhi);
+            }
+            return kept;
+
+        case ROLL_BOOL:
+            for (int i = 0; i < live; i++) {
+                uint64_t s = (state[i] * LCG_MUL + LCG_ADD) & LCG_MASK;
+                state[kept] = s;
+                rows[kept] = rows[i];
+                kept += !r->checked || (int)(s >> 47) == r->value;
+            }
+            return kept;
+
+        case ROLL_INT:
+            if ((r->n & (r->n - 1)) == 0) {
+                // Powers of two take one next(31) call and no rejection.
+                for (int i = 0; i < live; i++) {
+                    uint64_t s = (state[i] * LCG_MUL + LCG_ADD) & LCG_MASK;
+                    int v = (int)(((uint64_t)r->n * (s >> 17)) >> 31);
+                    state[kept] = s;
+                    rows[kept] = rows[i];
+                    kept += !r->checked || (v >= r->lo && v <= r->hi);
+                }
+            } else {
+                for (int i = 0; i < live; i++) {
+                    uint64_t s = state[i];
+                    int v = nextInt(&s, r->n);
+                    state[kept] = s;
+                    rows[kept] = rows[i];
+                    kept += !r->checked || (v >= r->lo && v <= r->hi);
+                }
+            }
+            return kept;
+    }
+    return live;
+}
+
+typedef struct {
+    const Roll *rolls;
+    int count;
+    const uint64_t *seeds;
+    const int *xs, *zs;   // NULL when the coordinate is the same for all rows
+    int x, z;
+    ResultBuf *results;
+} RollRun;
+
+static void roll_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    RollRun *run = (RollRun *)arg;
+    uint64_t state[ROLL_BLOCK];
+    int64_t rows[ROLL_BLOCK];
+
+    for (uint64_t base = lo; base < hi; base += ROLL_BLOCK) {
+        int live = hi - base < ROLL_BLOCK ? (int)(hi - base) : ROLL_BLOCK;
+        for (int i = 0; i < live; i++) {
+            uint64_t row = base + i;
+            int cx = run->xs ? run->xs[row] : run->x;
+            int cz = run->zs ? run->zs[row] : run->z;
+            state[i] = chunkGenerateRnd(run->seeds[row], cx, cz);
+            rows[i] = (int64_t)row;
+        }
+        for (int k = 0; k < run->count && live; k++) {
+            live = roll_apply(&run->rolls[k], state, rows, live);
+        }
+        for (int i = 0; i < live; i++) {
+            resultbuf_push(&run->results[tid], &rows[i]);
+        }
+    }
+}
+
+/*
+ * Reads a chunk coordinate argument, either one int for every row or an
+ * int32 buffer with one per row. Returns 1 if a buffer was acquired, 0 for
+ * an int, or -1 with an exception set.
+ */
+static int roll_coords(PyObject *obj, Py_ssize_t n, Py_buffer *view, int *value, const char *name) {
+    if (PyLong_Check(obj)) {
+        return fastcall_int(obj, value);
+    }
+    if (get_int32_buffer(obj, view, 0) < 0) {
+        return -1;
+    }
+    if (view->len / view->itemsize != n) {
+        PyBuffer_Release(view);
+        PyErr_Format(PyExc_ValueError, "%s must have one entry per seed", name);
+        return -1;
+    }
+    return 1;
+}
+
+static PyObject *RollProgram_run(RollProgramObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"lower48s", "chunk_xs", "chunk_zs", "threads", NULL};
+
+    PyObject *seeds_obj, *xs_obj, *zs_obj;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|$i", kwlist, &seeds_obj, &xs_obj, &zs_obj, &threads)) {
+        return NULL;
+    }
+    if (!self->rolls) {
+        PyErr_SetString(PyExc_RuntimeError, "RollProgram is not initialised");
+        return NULL;
+    }
+
+    Py_buffer seeds, xs, zs;
+    if (get_int64_buffer(seeds_obj, &seeds, 0) < 0) {
+        return NULL;
+    }
+    Py_ssize_t n = seeds.len / seeds.itemsize;
+
+    RollRun run = {0};
+    int has_xs = roll_coords(xs_obj, n, &xs, &run.x, "chunk_xs");
+    if (has_xs < 0) {
+        PyBuffer_Release(&seeds);
+        return NULL;
+    }
+    int has_zs = roll_coords(zs_obj, n, &zs, &run.z, "chunk_zs");
+    if (has_zs < 0) {
+        if (has_xs) PyBuffer_Release(&xs);
+        PyBuffer_Release(&seeds);
+        return NULL;
+    }
+
+    threads = resolve_thread_count(threads);
+    run.results = (ResultBuf *)malloc(threads * sizeof(ResultBuf));
+    if (!run.results) {
+        if (has_xs) PyBuffer_Release(&xs);
+        if (has_zs) PyBuffer_Release(&zs);
+        PyBuffer_Release(&seeds);
+        return PyErr_NoMemory();
+    }
+
+    run.rolls = self->rolls;
+    run.count = self->count;
+    run.seeds = (const uint64_t *)seeds.buf;
+    run.xs = has_xs ? (const int *)xs.buf : NULL;
+    run.zs = has_zs ? (const int *)zs.buf : NULL;
+
+    int64_t *rows;
+    size_t len;
+    int failed;
+
+    self->running++;
+    Py_BEGIN_ALLOW_THREADS
+    for (int i = 0; i < threads; i++) {
+        resultbuf_init(&run.results[i], sizeof(int64_t));
+    }
+    threads = parallel_range(0, n, 1 << 14, threads, roll_worker, &run);
+    rows = (int64_t *)resultbuf_merge(run.results, threads, &len, &failed);
+    if (rows) {
+        // Blocks finish out of order, so return the rows sorted.
+        qsort(rows, len, sizeof(int64_t), compare_u64);
+    }
+    Py_END_ALLOW_THREADS
+    self->running--;
+
+    free(run.results);
+    if (has_xs) PyBuffer_Release(&xs);
+    if (has_zs) PyBuffer_Release(&zs);
+    PyBuffer_Release(&seeds);
+
+    if (failed) {
+        free(rows);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *)Array_from_data(rows, 'q', sizeof(int64_t), len, 0);
+}
+
+static Py_ssize_t RollProgram_len(RollProgramObject *self) {
+    return self->count;
+}
+
+static PyMethodDef RollProgram_methods[] = {
+    {"run", (PyCFunction) RollProgram_run, METH_VARARGS | METH_KEYWORDS, "Rolls the chunk seed of each (lower48, chunk x, chunk z) row and returns the indices of the rows that pass every roll as an int64 array"},
+    {NULL}  /* Sentinel */
+};
+
+static PySequenceMethods RollProgram_as_sequence = {
+    .sq_length = (lenfunc) RollProgram_len,
+};
+
+PyTypeObject RollProgramType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.RollProgram",
+    .tp_doc = "A sequence of Java Random rolls evaluated natively over batches of chunk seeds",
+    .tp_basicsize = sizeof(RollProgramObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) RollProgram_init,
+    .tp_dealloc = (destructor) RollProgram_dealloc,
+    .tp_methods = RollProgram_methods,
+    .tp_as_sequence = &RollProgram_as_sequence,
+};
@@ -0,0 +1,446 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+/*
+ * SearchJob runs a Pipeline over a long range of structure seeds in chunks
+ * and survives restarts. After each chunk the survivors are appended to the
+ * results file, one decimal seed per line, and the checkpoint file is
+ * replaced with the next chunk start and the size of the results file.
+ *
+ * On resume the results file is truncated to the checkpointed size, which
+ * drops anything appended by a chunk that did not finish, and the scan
+ * continues from the checkpointed position. Chunks run in order, so the
+ * completed part of the range is always [lo, next).
+ */
+
+#define SEARCH_JOB_MAGIC "pybiomes-search-job"
+
+// 64-bit file positions, which long is not on Windows.
+#ifdef _WIN32
+#define search_job_ftell _ftelli64
+#else
+#define search_job_ftell ftello
+#endif
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *pipeline;
+    PyObject *checkpoint;   // str path
+    PyObject *results;      // str path
+    uint64_t lo, hi, next;
+    uint64_t chunk;
+    int threads;
+    unsigned long long found;
+    unsigned long long results_size;
+} SearchJobObject;
+
+static int SearchJob_traverse(SearchJobObject *self, visitproc visit, void *arg) {
+    Py_VISIT(self->pipeline);
+    return 0;
+}
+
+static int SearchJob_clear(SearchJobObject *self) {
+    Py_CLEAR(self->pipeline);
+    return 0;
+}
+
+static void SearchJob_dealloc(SearchJobObject *self) {
+    PyObject_GC_UnTrack(self);
+    SearchJob_clear(self);
+    Py_XDECREF(self->checkpoint);
+    Py_XDECREF(self->results);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+// Calls os.<name>(*args), returning a new reference or NULL.
+static PyObject *SearchJob_call_os(const char *name, const char *format, ...) {
+    PyObject *os = PyImport_ImportModule("os");
+    if (!os) {
+        return NULL;
+    }
+    PyObject *fn = PyObject_GetAttrString(os, name);
+    Py_DECREF(os);
+    if (!fn) {
+        return NULL;
+    }
+
+    va_list va;
+    va_start(va, format);
+    PyObject *args = Py_VaBuildValue(format, va);
+    va_end(va);
+    if (!args) {
+        Py_DECREF(fn);
+        return NULL;
+    }
+
+    PyObject *ret = PyObject_CallObject(fn, args);
+    Py_DECREF(fn);
+    Py_DECREF(args);
+    return ret;
+}
+
+// fopen on a str path. Returns NULL with errno set if the file cannot be
+// opened, or with an exception set if the path cannot be encoded.
+static FILE *SearchJob_fopen(PyObject *path, const char *mode) {
+    PyObject *bytes = PyUnicode_EncodeFSDefault(path);
+    if (!bytes) {
+        return NULL;
+    }
+    errno = 0;
+    FILE *f = fopen(PyBytes_AS_STRING(bytes), mode);
+    Py_DECREF(bytes);
+    return f;
+}
+
+static int SearchJob_io_error(PyObject *path) {
+    if (!PyErr_Occurred()) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+    }
+    return -1;
+}
+
+/*
+ * Syncs the directory holding path, so a rename into it survives a power
+ * loss. Windows cannot open directories and has no equivalent, so this
+ * does nothing there.
+ */
+static int SearchJob_sync_dir(PyObject *path) {
+#ifdef _WIN32
+    return 0;
+#else
+    PyObject *os = PyImport_ImportModule("os");
+    if (!os) {
+        return -1;
+    }
+    PyObject *dir = PyObject_CallMethod(os, "fspath", "O", path);
+    PyObject *ospath = PyObject_GetAttrString(os, "path");
+    if (dir && ospath) {
+        Py_SETREF(dir, PyObject_CallMethod(ospath, "dirname", "O", dir));
+    }
+    // A bare file name is in the current directory.
+    if (dir && PyUnicode_Check(dir) && PyUnicode_GET_LENGTH(dir) == 0) {
+        Py_SETREF(dir, PyUnicode_FromString("."));
+    }
+    PyObject *fd = NULL;
+    if (dir) {
+        fd = PyObject_CallMethod(os, "open", "Oi", dir, O_RDONLY);
+    }
+    int err = !fd;
+    if (fd) {
+        PyObject *ret = PyObject_CallMethod(os, "fsync", "O", fd);
+        err = !ret;
+        Py_XDECREF(ret);
+        PyObject *type, *value, *traceback;
+        PyErr_Fetch(&type, &value, &traceback);
+        ret = PyObject_CallMethod(os, "close", "O", fd);
+        Py_XDECREF(ret);
+        if (err) {
+            PyErr_Restore(type, value, traceback);
+        } else if (!ret) {
+            err = 1;
+        }
+    }
+    Py_XDECREF(fd);
+    Py_XDECREF(dir);
+    Py_XDECREF(ospath);
+    Py_DECREF(os);
+    return err ? -1 : 0;
+#endif
+}
+
+/*
+ * Writes the checkpoint to a temporary file, syncs it and moves it over
+ * the old one, so a crash leaves either the old or the new checkpoint
+ * intact.
+ */
+static int SearchJob_save(SearchJobObject *self) {
+    PyObject *tmp = PyUnicode_FromFormat("%U.tmp", self->checkpoint);
+    if (!tmp) {
+        return -1;
+    }
+
+    FILE *f = SearchJob_fopen(tmp, "w");
+    if (!f) {
+        SearchJob_io_error(tmp);
+        Py_DECREF(tmp);
+        return -1;
+    }
+    fprintf(f, "%s %llu %llu %llu %llu %llu\n", SEARCH_JOB_MAGIC,
+        (unsigned long long)self->lo, (unsigned long long)self->hi, (unsigned long long)self->next,
+        self->results_size, self->found);
+    if (fflush(f) != 0 || ferror(f)) {
+        fclose(f);
+        SearchJob_io_error(tmp);
+        Py_DECREF(tmp);
+        return -1;
+    }
+    PyObject *ret = SearchJob_call_os("fsync", "(i)", fileno(f));
+    if (!ret) {
+        fclose(f);
+        Py_DECREF(tmp);
+        return -1;
+    }
+    Py_DECREF(ret);
+    if (fclose(f) != 0) {
+        SearchJob_io_error(tmp);
+        Py_DECREF(tmp);
+        return -1;
+    }
+
+    ret = SearchJob_call_os("replace", "(OO)", tmp, self->checkpoint);
+    Py_DECREF(tmp);
+    if (!ret) {
+        return -1;
+    }
+    Py_DECREF(ret);
+    return SearchJob_sync_dir(self->checkpoint);
+}
+
+/*
+ * Loads an existing checkpoint and cuts the results file back to it.
+ * Without a checkpoint the results file must be missing or empty, since
+ * its seeds could not be attributed to any part of the range.
+ */
+static int SearchJob_load(SearchJobObject *self) {
+    FILE *f = SearchJob_fopen(self->checkpoint, "r");
+    if (!f) {
+        if (PyErr_Occurred() || errno != ENOENT) {
+            return SearchJob_io_error(self->checkpoint);
+        }
+
+        FILE *r = SearchJob_fopen(self->results, "rb");
+        if (!r) {
+            if (PyErr_Occurred()) {
+                return -1;
+            }
+            return 0;
+        }
+        int empty = fgetc(r) == EOF;
+        fclose(r);
+        if (!empty) {
+            PyErr_SetString(PyExc_ValueError, "Results file is not empty but there is no checkpoint");
+            return -1;
+        }
+        return 0;
+    }
+
+    char magic[32];
+    unsigned long long lo, hi, next, size, found;
+    int n = fscanf(f, "%31s %llu %llu %llu %llu %llu", magic, &lo, &hi, &next, &size, &found);
+    fclose(f);
+
+    if (n != 6 || strcmp(magic, SEARCH_JOB_MAGIC) != 0 || next < lo || next > hi) {
+        PyErr_SetString(PyExc_ValueError, "Checkpoint file is not a valid search job checkpoint");
+        return -1;
+    }
+    if (lo != self->lo || hi != self->hi) {
+        PyErr_Format(PyExc_ValueError, "Checkpoint is for the range [%llu, %llu)", lo, hi);
+        return -1;
+    }
+
+    // A results file shorter than the checkpoint has lost seeds, and
+    // truncating it would pad it with NULs instead.
+    long long actual = 0;
+    FILE *r = SearchJob_fopen(self->results, "rb");
+    if (r) {
+        if (fseek(r, 0, SEEK_END) == 0) {
+            actual = search_job_ftell(r);
+        } else {
+            actual = -1;
+        }
+        fclose(r);
+        if (actual < 0) {
+            return SearchJob_io_error(self->results);
+        }
+    } else if (PyErr_Occurred() || errno != ENOENT) {
+        return SearchJob_io_error(self->results);
+    }
+    if ((unsigned long long)actual < size) {
+        PyErr_Format(PyExc_ValueError, "Results file is shorter than the %llu bytes in the checkpoint", size);
+        return -1;
+    }
+
+    // Drop seeds appended by a chunk that never reached its checkpoint.
+    if ((unsigned long long)actual > size) {
+        PyObject *ret = SearchJob_call_os("truncate", "(OK)", self->results, size);
+        if (!ret) {
+            return -1;
+        }
+        Py_DECREF(ret);
+    }
+
+    self->next = next;
+    self->results_size = size;
+    self->found = found;
+    return 1;
+}
+
+static int SearchJob_init(SearchJobObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"pipeline", "lo", "hi", "checkpoint", "results", "chunk", "threads", NULL};
+
+    PyObject *pipeline, *checkpoint, *results;
+    uint64_t lo, hi;
+    uint64_t chunk = 1 << 16;
+    int threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!KKO&O&|$Ki", kwlist,
+            &PipelineType, &pipeline, &lo, &hi,
+            PyUnicode_FSDecoder, &checkpoint, PyUnicode_FSDecoder, &results,
+            &chunk, &threads)) {
+        return -1;
+    }
+
+    Py_INCREF(pipeline);
+    Py_XSETREF(self->pipeline, pipeline);
+    Py_XSETREF(self->checkpoint, checkpoint);
+    Py_XSETREF(self->results, results);
+
+    if (lo > hi || hi > (1ULL << 48)) {
+        PyErr_SetString(PyExc_ValueError, "Seed range must satisfy 0 <= lo <= hi <= 2**48");
+        return -1;
+    }
+
+    self->lo = lo;
+    self->hi = hi;
+    self->next = lo;
+    self->chunk = chunk ? chunk : 1;
+    self->threads = threads;
+    self->found = 0;
+    self->results_size = 0;
+
+    return SearchJob_load(self) < 0 ? -1 : 0;
+}
+
+// Appends seeds to the results file, one per line, and syncs it to disk.
+static int SearchJob_append(SearchJobObject *self, FILE *f, PyObject *seeds) {
+    Py_buffer view;
+    if (get_int64_buffer(seeds, &view, 0) < 0) {
+        return -1;
+    }
+
+    const uint64_t *s = (const uint64_t *)view.buf;
+    Py_ssize_t n = view.len / view.itemsize;
+    for (Py_ssize_t i = 0; i < n; i++) {
+        fprintf(f, "%llu\n", (unsigned long long)s[i]);
+    }
+    PyBuffer_Release(&view);
+
+    if (fflush(f) != 0 || ferror(f)) {
+        return SearchJob_io_error(self->results);
+    }
+    PyObject *ret = SearchJob_call_os("fsync", "(i)", fileno(f));
+    if (!ret) {
+        return -1;
+    }
+    Py_DECREF(ret);
+
+    long long size = search_job_ftell(f);
+    if (size < 0) {
+        return SearchJob_io_error(self->results);
+    }
+    self->results_size = (unsigned long long)size;
+    self->found += n;
+    return 0;
+}
+
+static PyObject *SearchJob_run(SearchJobObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"max_chunks", NULL};
+
+    long long max_chunks = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|L", kwlist, &max_chunks)) {
+        return NULL;
+    }
+    if (!self->pipeline) {
+        PyErr_SetString(PyExc_RuntimeError, "SearchJob is not initialised");
+        return NULL;
+    }
+
+    FILE *f = SearchJob_fopen(self->results, "ab");
+    if (!f) {
+        SearchJob_io_error(self->results);
+        return NULL;
+    }
+    // Where an append stream starts is implementation-defined.
+    fseek(f, 0, SEEK_END);
+
+    unsigned long long before = self->found;
+    long long chunks = 0;
+    int err = 0;
+
+    while (self->next < self->hi && (max_chunks < 0 || chunks < max_chunks)) {
+        uint64_t end = self->hi - self->next > self->chunk ? self->next + self->chunk : self->hi;
+
+        PyObject *seeds = PyObject_CallMethod(self->pipeline, "run", "KKi",
+            (unsigned long long)self->next, (unsigned long long)end, self->threads);
+        if (!seeds) {
+            err = 1;
+            break;
+        }
+        err = SearchJob_append(self, f, seeds) < 0;
+        Py_DECREF(seeds);
+        if (err) {
+            break;
+        }
+
+        self->next = end;
+        chunks++;
+        if (SearchJob_save(self) < 0 || PyErr_CheckSignals() < 0) {
+            err = 1;
+            break;
+        }
+    }
+
+    fclose(f);
+    if (err) {
+        return NULL;
+    }
+    return PyLong_FromUnsignedLongLong(self->found - before);
+}
+
+static PyObject *SearchJob_get_done(SearchJobObject *self, void *closure) {
+    return PyBool_FromLong(self->next >= self->hi);
+}
+
+static PyMethodDef SearchJob_methods[] = {
+    {"run", (PyCFunction) SearchJob_run, METH_VARARGS | METH_KEYWORDS, "Runs up to max_chunks chunks (all by default), checkpointing after each; returns the number of new seeds"},
+    {NULL}  /* Sentinel */
+};
+
+static PyMemberDef SearchJob_members[] = {
+    {"lo", T_ULONGLONG, offsetof(SearchJobObject, lo), READONLY, "Start of the seed range"},
+    {"hi", T_ULONGLONG, offsetof(SearchJobObject, hi), READONLY, "End of the seed range"},
+    {"next", T_ULONGLONG, offsetof(SearchJobObject, next), READONLY, "Start of the first chunk not yet completed"},
+    {"found", T_ULONGLONG, offsetof(SearchJobObject, found), READONLY, "Number of seeds in the results file"},
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef SearchJob_getsets[] = {
+    {"done", (getter)SearchJob_get_done, NULL, "Whether the whole range has been searched", NULL},
+    {NULL, 0, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyTypeObject SearchJobType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.SearchJob",
+    .tp_doc = "Checkpointed, resumable Pipeline search over a range of structure seeds",
+    .tp_basicsize = sizeof(SearchJobObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) SearchJob_init,
+    .tp_dealloc = (destructor) SearchJob_dealloc,
+    .tp_traverse = (traverseproc) SearchJob_traverse,
+    .tp_clear = (inquiry) SearchJob_clear,
+    .tp_methods = SearchJob_methods,
+    .tp_members = SearchJob_members,
+    .tp_getset = SearchJob_getsets,
+};
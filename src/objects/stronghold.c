@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdbool.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#include "../external/cubiomes/finders.h"
+
+/*
+ * StrongholdIterator walks the strongholds of a seeded Generator, keeping
+ * the cubiomes StrongholdIter natively between steps. The generator is
+ * referenced, not copied, and each step runs under its lock.
+ */
+typedef struct {
+    PyObject_HEAD
+    StrongholdIter sh;
+    GeneratorObject *generator;
+    int count;
+    int produced;
+    int done;
+} StrongholdIteratorObject;
+
+extern PyTypeObject StrongholdIteratorType;
+
+static int StrongholdIterator_traverse(StrongholdIteratorObject *self, visitproc visit, void *arg) {
+    Py_VISIT(self->generator);
+    return 0;
+}
+
+static int StrongholdIterator_clear(StrongholdIteratorObject *self) {
+    Py_CLEAR(self->generator);
+    return 0;
+}
+
+static void StrongholdIterator_dealloc(StrongholdIteratorObject *self) {
+    PyObject_GC_UnTrack(self);
+    StrongholdIterator_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int StrongholdIterator_init(StrongholdIteratorObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"generator", "count", NULL};
+
+    PyObject *gen_obj;
+    int count = 128;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, GENERATOR_OBJECT_TYPE "|i", kwlist, &GeneratorType, &gen_obj, &count)) {
+        return -1;
+    }
+
+    GeneratorObject *gen = (GeneratorObject *)gen_obj;
+    uint64_t seed;
+    int mc;
+
+    GENERATOR_BEGIN_ALLOW_THREADS(gen)
+    seed = gen->generator.seed;
+    mc = gen->generator.mc;
+    GENERATOR_END_ALLOW_THREADS(gen)
+
+    initFirstStronghold(&self->sh, mc, seed);
+
+    Py_INCREF(gen_obj);
+    Py_XSETREF(self->generator, gen);
+    self->count = count;
+    self->produced = 0;
+    self->done = count <= 0;
+
+    return 0;
+}
+
+static PyObject *StrongholdIterator_iter(StrongholdIteratorObject *self) {
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+// Yields the position of each stronghold in turn.
+static PyObject *StrongholdIterator_next(StrongholdIteratorObject *self) {
+    if (!self->generator) {
+        PyErr_SetString(PyExc_RuntimeError, "StrongholdIterator is not initialised");
+        return NULL;
+    }
+    if (self->done) {
+        return NULL;
+    }
+
+    int remaining;
+    GENERATOR_BEGIN_ALLOW_THREADS(self->generator)
+    remaining = nextStronghold(&self->sh, &self->generator->generator);
+    GENERATOR_END_ALLOW_THREADS(self->generator)
+
+    // nextStronghold returns the number of strongholds left after this one.
+    self->produced++;
+    if (remaining <= 0 || self->produced >= self->count) {
+        self->done = 1;
+    }
+
+    PosObject *pos = (PosObject *)Pos_new(&PosType, NULL, NULL);
+    if (!pos) {
+        return NULL;
+    }
+    pos->pos = self->sh.pos;
+    return (PyObject *)pos;
+}
+
+static PyObject *StrongholdIterator_get_nextapprox(StrongholdIteratorObject *self, void *closure) {
+    PosObject *pos = (PosObject *)Pos_new(&PosType, NULL, NULL);
+    if (!pos) {
+        return NULL;
+    }
+    pos->pos = self->sh.nextapprox;
+    return (PyObject *)pos;
+}
+
+static PyGetSetDef StrongholdIterator_getsets[] = {
+    {"nextapprox", (getter)StrongholdIterator_get_nextapprox, NULL, "Approximate position of the next stronghold", NULL},
+    {NULL, 0, NULL, NULL, NULL} /* Sentinel */
+};
+
+static PyMemberDef StrongholdIterator_members[] = {
+    {"index", T_INT, offsetof(StrongholdIteratorObject, sh.index), READONLY, "Index of the next stronghold"},
+    {"ringnum", T_INT, offsetof(StrongholdIteratorObject, sh.ringnum), READONLY, "Ring of the next stronghold"},
+    {"produced", T_INT, offsetof(StrongholdIteratorObject, produced), READONLY, "Number of strongholds yielded so far"},
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject StrongholdIteratorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.StrongholdIterator",
+    .tp_doc = "Iterates over the stronghold positions of a seeded Generator",
+    .tp_basicsize = sizeof(StrongholdIteratorObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) StrongholdIterator_init,
+    .tp_dealloc = (destructor) StrongholdIterator_dealloc,
+    .tp_traverse = (traverseproc) StrongholdIterator_traverse,
+    .tp_clear = (inquiry) StrongholdIterator_clear,
+    .tp_iter = (getiterfunc) StrongholdIterator_iter,
+    .tp_iternext = (iternextfunc) StrongholdIterator_next,
+    .tp_members = StrongholdIterator_members,
+    .tp_getset = StrongholdIterator_getsets,
+};
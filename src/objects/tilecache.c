@@ -0,0 +1,554 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+/*
+ * BiomeTileCache serves square tiles of gen_biomes output, keyed by
+ * (seed, dim, scale, y, tx, tz), from a cache file so that a tile is only
+ * generated once. Tile (tx, tz) covers the cells [tx * tile, (tx + 1) * tile)
+ * by [tz * tile, (tz + 1) * tile) of its scale.
+ *
+ * The file is a header followed by records, each a key and then the tile's
+ * biome ids as one byte per cell, rows along z. Records are only appended,
+ * and the keys in front of them are the index, which is read into a hash
+ * table on open. Tiles are read back through a read-only memory map of the
+ * file, which is mapped again once records beyond its end are needed. A
+ * record cut short by a crash is dropped on open.
+ *
+ * Every scale is generated by genBiomes directly. Coarse tiles are not
+ * built from finer cached ones, as cubiomes samples the scales above 1:4
+ * differently and the results would not match.
+ */
+
+#define TILE_CACHE_MAGIC "pybiomes-tiles"
+#define TILE_CACHE_FORMAT 1
+#define TILE_HEADER_SIZE 64
+#define TILE_KEY_SIZE 32
+
+typedef struct {
+    uint64_t seed;
+    int32_t dim, scale, y, tx, tz;
+} TileKey;
+
+typedef struct {
+    TileKey key;
+    int64_t record;     // -1 for an empty slot
+} TileSlot;
+
+typedef struct {
+    PyObject_HEAD
+    Generator generator;
+    int seeded;
+    int dim;
+    uint64_t seed;
+    int tile;
+    PyObject *path;
+    PyObject *file;     // buffered r+b file object
+    PyObject *map;      // mmap.mmap of the file, or NULL
+    Py_buffer view;     // of map
+    long long size;     // end of the last complete record
+    TileSlot *slots;
+    size_t slot_count;  // power of two
+    size_t count;
+    unsigned long long hits, generated;
+    int running;
+} BiomeTileCacheObject;
+
+static size_t TileCache_record_size(const BiomeTileCacheObject *self) {
+    return TILE_KEY_SIZE + (size_t)self->tile * self->tile;
+}
+
+static uint64_t tile_key_hash(const TileKey *k) {
+    uint64_t h = k->seed;
+    h = (h ^ (uint32_t)k->dim ^ ((uint64_t)(uint32_t)k->scale << 32)) * 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (uint32_t)k->y ^ ((uint64_t)(uint32_t)k->tx << 32)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (uint32_t)k->tz) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static int tile_key_equal(const TileKey *a, const TileKey *b) {
+    return a->seed == b->seed && a->dim == b->dim && a->scale == b->scale &&
+        a->y == b->y && a->tx == b->tx && a->tz == b->tz;
+}
+
+// Returns the record holding key, or -1.
+static int64_t TileCache_find(const BiomeTileCacheObject *self, const TileKey *key) {
+    if (!self->slot_count) {
+        return -1;
+    }
+    size_t mask = self->slot_count - 1;
+    for (size_t i = tile_key_hash(key) & mask; self->slots[i].record >= 0; i = (i + 1) & mask) {
+        if (tile_key_equal(&self->slots[i].key, key)) {
+            return self->slots[i].record;
+        }
+    }
+    return -1;
+}
+
+static void TileCache_place(TileSlot *slots, size_t slot_count, const TileKey *key, int64_t record) {
+    size_t mask = slot_count - 1, i = tile_key_hash(key) & mask;
+    while (slots[i].record >= 0) {
+        i = (i + 1) & mask;
+    }
+    slots[i].key = *key;
+    slots[i].record = record;
+}
+
+// Adds a key to the index, keeping it at most half full. Returns 0 or -1.
+static int TileCache_insert(BiomeTileCacheObject *self, const TileKey *key, int64_t record) {
+    if (2 * (self->count + 1) > self->slot_count) {
+        size_t slot_count = self->slot_count ? 2 * self->slot_count : 256;
+        TileSlot *slots = (TileSlot *)malloc(slot_count * sizeof(TileSlot));
+        if (!slots) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        for (size_t i = 0; i < slot_count; i++) {
+            slots[i].record = -1;
+        }
+        for (size_t i = 0; i < self->slot_count; i++) {
+            if (self->slots[i].record >= 0) {
+                TileCache_place(slots, slot_count, &self->slots[i].key, self->slots[i].record);
+            }
+        }
+        free(self->slots);
+        self->slots = slots;
+        self->slot_count = slot_count;
+    }
+    TileCache_place(self->slots, self->slot_count, key, record);
+    self->count++;
+    return 0;
+}
+
+static void tile_key_store(const TileKey *k, unsigned char *out) {
+    memset(out, 0, TILE_KEY_SIZE);
+    memcpy(out, &k->seed, 8);
+    memcpy(out + 8, &k->dim, 4);
+    memcpy(out + 12, &k->scale, 4);
+    memcpy(out + 16, &k->y, 4);
+    memcpy(out + 20, &k->tx, 4);
+    memcpy(out + 24, &k->tz, 4);
+}
+
+static void tile_key_load(TileKey *k, const unsigned char *in) {
+    memcpy(&k->seed, in, 8);
+    memcpy(&k->dim, in + 8, 4);
+    memcpy(&k->scale, in + 12, 4);
+    memcpy(&k->y, in + 16, 4);
+    memcpy(&k->tx, in + 20, 4);
+    memcpy(&k->tz, in + 24, 4);
+}
+
+static void TileCache_unmap(BiomeTileCacheObject *self) {
+    if (self->view.obj) {
+        PyBuffer_Release(&self->view);
+    }
+    if (self->map) {
+        PyObject *ret = PyObject_CallMethod(self->map, "close", NULL);
+        Py_XDECREF(ret);
+        PyErr_Clear();
+        Py_CLEAR(self->map);
+    }
+}
+
+// Maps the records written so far. Returns 0, or -1 with an exception set.
+static int TileCache_map(BiomeTileCacheObject *self) {
+    TileCache_unmap(self);
+    if (self->size <= TILE_HEADER_SIZE) {
+        return 0;
+    }
+
+    PyObject *mmap = PyImport_ImportModule("mmap");
+    if (!mmap) {
+        return -1;
+    }
+    PyObject *type = PyObject_GetAttrString(mmap, "mmap");
+    PyObject *access = PyObject_GetAttrString(mmap, "ACCESS_READ");
+    PyObject *fileno = PyObject_CallMethod(self->file, "fileno", NULL);
+    Py_DECREF(mmap);
+
+    PyObject *args = NULL, *kwds = NULL;
+    if (type && access && fileno) {
+        args = Py_BuildValue("(OL)", fileno, self->size);
+        kwds = Py_BuildValue("{sO}", "access", access);
+    }
+    if (args && kwds) {
+        self->map = PyObject_Call(type, args, kwds);
+    }
+    Py_XDECREF(type);
+    Py_XDECREF(access);
+    Py_XDECREF(fileno);
+    Py_XDECREF(args);
+    Py_XDECREF(kwds);
+
+    if (!self->map || PyObject_GetBuffer(self->map, &self->view, PyBUF_SIMPLE) < 0) {
+        Py_CLEAR(self->map);
+        return -1;
+    }
+    return 0;
+}
+
+// Returns the stored tile of a record, mapping the file again if needed.
+static const unsigned char *TileCache_record(BiomeTileCacheObject *self, int64_t record) {
+    long long offset = TILE_HEADER_SIZE + record * (long long)TileCache_record_size(self);
+    if (!self->view.obj || offset + (long long)TileCache_record_size(self) > self->view.len) {
+        if (TileCache_map(self) < 0) {
+            return NULL;
+        }
+    }
+    return (const unsigned char *)self->view.buf + offset + TILE_KEY_SIZE;
+}
+
+// Unmaps and closes the file, keeping any exception already set.
+static void TileCache_close_file(BiomeTileCacheObject *self) {
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    TileCache_unmap(self);
+    if (self->file) {
+        PyObject *ret = PyObject_CallMethod(self->file, "close", NULL);
+        Py_XDECREF(ret);
+        PyErr_Clear();
+        Py_CLEAR(self->file);
+    }
+    PyErr_Restore(type, value, traceback);
+    free(self->slots);
+    self->slots = NULL;
+    self->slot_count = 0;
+    self->count = 0;
+}
+
+static void BiomeTileCache_dealloc(BiomeTileCacheObject *self) {
+    TileCache_close_file(self);
+    Py_XDECREF(self->path);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+/*
+ * Opens or creates the cache file, checks its header and reads the index.
+ * Returns 0, or -1 with an exception set.
+ */
+static int TileCache_open(BiomeTileCacheObject *self) {
+    PyObject *io = PyImport_ImportModule("io");
+    if (!io) {
+        return -1;
+    }
+    // Creates the file if it is missing, without truncating it.
+    PyObject *f = PyObject_CallMethod(io, "open", "Os", self->path, "ab");
+    if (f) {
+        PyObject *ret = PyObject_CallMethod(f, "close", NULL);
+        Py_DECREF(f);
+        Py_XDECREF(ret);
+        if (ret) {
+            self->file = PyObject_CallMethod(io, "open", "Os", self->path, "r+b");
+        }
+    }
+    Py_DECREF(io);
+    if (!self->file) {
+        return -1;
+    }
+
+    unsigned char header[TILE_HEADER_SIZE] = {0};
+    int mc = self->generator.mc;
+    uint32_t format = TILE_CACHE_FORMAT, tile = self->tile, flags = self->generator.flags;
+    memcpy(header, TILE_CACHE_MAGIC, sizeof(TILE_CACHE_MAGIC) - 1);
+    memcpy(header + 16, &format, 4);
+    memcpy(header + 20, &tile, 4);
+    memcpy(header + 24, &mc, 4);
+    memcpy(header + 28, &flags, 4);
+
+    PyObject *existing = PyObject_CallMethod(self->file, "read", "i", TILE_HEADER_SIZE);
+    if (!existing) {
+        return -1;
+    }
+    if (!PyBytes_Check(existing)) {
+        Py_DECREF(existing);
+        PyErr_SetString(PyExc_TypeError, "Cache file read did not return bytes");
+        return -1;
+    }
+    Py_ssize_t len = PyBytes_GET_SIZE(existing);
+    int valid = len == TILE_HEADER_SIZE && memcmp(PyBytes_AS_STRING(existing), header, 16) == 0;
+    int matches = valid && memcmp(PyBytes_AS_STRING(existing), header, TILE_HEADER_SIZE) == 0;
+    Py_DECREF(existing);
+
+    if (len == 0) {
+        PyObject *data = PyBytes_FromStringAndSize((const char *)header, TILE_HEADER_SIZE);
+        if (!data) {
+            return -1;
+        }
+        PyObject *ret = PyObject_CallMethod(self->file, "write", "O", data);
+        Py_DECREF(data);
+        if (!ret) {
+            return -1;
+        }
+        Py_DECREF(ret);
+        ret = PyObject_CallMethod(self->file, "flush", NULL);
+        if (!ret) {
+            return -1;
+        }
+        Py_DECREF(ret);
+    } else if (!valid) {
+        PyErr_SetString(PyExc_ValueError, "File is not a biome tile cache");
+        return -1;
+    } else if (!matches) {
+        PyErr_SetString(PyExc_ValueError, "Tile cache was written for another version, flags or tile size");
+        return -1;
+    }
+
+    PyObject *end = PyObject_CallMethod(self->file, "seek", "ii", 0, 2);
+    long long size = end ? PyLong_AsLongLong(end) : -1;
+    Py_XDECREF(end);
+    if (size < 0) {
+        return -1;
+    }
+
+    // Drop a record cut short by a crash.
+    long long record_size = (long long)TileCache_record_size(self);
+    long long records = (size - TILE_HEADER_SIZE) / record_size;
+    self->size = TILE_HEADER_SIZE + records * record_size;
+    if (self->size != size) {
+        PyObject *ret = PyObject_CallMethod(self->file, "truncate", "L", self->size);
+        if (!ret) {
+            return -1;
+        }
+        Py_DECREF(ret);
+    }
+
+    if (TileCache_map(self) < 0) {
+        return -1;
+    }
+    for (long long i = 0; i < records; i++) {
+        TileKey key;
+        tile_key_load(&key, (const unsigned char *)self->view.buf + TILE_HEADER_SIZE + i * record_size);
+        if (TileCache_find(self, &key) < 0 && TileCache_insert(self, &key, i) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int BiomeTileCache_init(BiomeTileCacheObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"generator", "path", "tile", NULL};
+
+    GeneratorObject *generator;
+    PyObject *path;
+    int tile = 256;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&|$i", kwlist, &GeneratorType, &generator,
+            PyUnicode_FSDecoder, &path, &tile)) {
+        return -1;
+    }
+    if (self->running) {
+        Py_DECREF(path);
+        PyErr_SetString(PyExc_RuntimeError, "BiomeTileCache is in use");
+        return -1;
+    }
+    Py_XSETREF(self->path, path);
+    TileCache_close_file(self);
+
+    if (tile < 16 || tile > 1024) {
+        PyErr_SetString(PyExc_ValueError, "tile must be between 16 and 1024");
+        return -1;
+    }
+
+    int mc;
+    uint32_t flags;
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(generator->lock, WAIT_LOCK);
+    mc = generator->generator.mc;
+    flags = generator->generator.flags;
+    PyThread_release_lock(generator->lock);
+    setupGenerator(&self->generator, mc, flags);
+    Py_END_ALLOW_THREADS
+
+    self->seeded = 0;
+    self->tile = tile;
+    self->hits = self->generated = 0;
+
+    if (TileCache_open(self) < 0) {
+        TileCache_close_file(self);
+        return -1;
+    }
+    return 0;
+}
+
+// Generates a tile into ids. Returns 0, or -1 with an exception set.
+static int TileCache_generate(BiomeTileCacheObject *self, const TileKey *key, int *ids) {
+    int t = self->tile;
+    Range r;
+    r.scale = key->scale;
+    r.x = key->tx * t;
+    r.z = key->tz * t;
+    r.sx = t;
+    r.sz = t;
+    r.y = key->y;
+    r.sy = 1;
+
+    int *cache = (int *)malloc(getMinCacheSize(&self->generator, r.scale, r.sx, r.sy, r.sz) * sizeof(int));
+    if (!cache) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    int err;
+    self->running = 1;
+    Py_BEGIN_ALLOW_THREADS
+    if (!self->seeded || self->seed != key->seed || self->dim != key->dim) {
+        apply_seed_cached(&self->generator, key->dim, key->seed);
+        self->seeded = 1;
+        self->seed = key->seed;
+        self->dim = key->dim;
+    }
+    err = genBiomes(&self->generator, cache, r);
+    if (!err) {
+        memcpy(ids, cache, (size_t)t * t * sizeof(int));
+    }
+    Py_END_ALLOW_THREADS
+    self->running = 0;
+    free(cache);
+
+    if (err) {
+        PyErr_SetString(PyExc_RuntimeError, "genBiomes returned a non-zero value, indicating an error.");
+        return -1;
+    }
+    return 0;
+}
+
+// Appends a tile to the file and the index. Returns 0, or -1 with an exception set.
+static int TileCache_append(BiomeTileCacheObject *self, const TileKey *key, const int *ids) {
+    size_t cells = (size_t)self->tile * self->tile;
+    PyObject *data = PyBytes_FromStringAndSize(NULL, TileCache_record_size(self));
+    if (!data) {
+        return -1;
+    }
+    unsigned char *p = (unsigned char *)PyBytes_AS_STRING(data);
+    tile_key_store(key, p);
+    for (size_t i = 0; i < cells; i++) {
+        p[TILE_KEY_SIZE + i] = (unsigned char)ids[i];
+    }
+
+    PyObject *ret = PyObject_CallMethod(self->file, "seek", "L", self->size);
+    if (ret) {
+        Py_DECREF(ret);
+        ret = PyObject_CallMethod(self->file, "write", "O", data);
+    }
+    if (ret) {
+        Py_DECREF(ret);
+        ret = PyObject_CallMethod(self->file, "flush", NULL);
+    }
+    Py_DECREF(data);
+    if (!ret) {
+        return -1;
+    }
+    Py_DECREF(ret);
+
+    int64_t record = (self->size - TILE_HEADER_SIZE) / (long long)TileCache_record_size(self);
+    self->size += TileCache_record_size(self);
+    return TileCache_insert(self, key, record);
+}
+
+static PyObject *BiomeTileCache_get(BiomeTileCacheObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"seed", "dim", "scale", "y", "tx", "tz", NULL};
+
+    TileKey key;
+    unsigned long long seed;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Kiiiii", kwlist, &seed, &key.dim, &key.scale, &key.y, &key.tx, &key.tz)) {
+        return NULL;
+    }
+    key.seed = seed;
+
+    if (!self->file) {
+        PyErr_SetString(PyExc_RuntimeError, "BiomeTileCache is closed");
+        return NULL;
+    }
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "BiomeTileCache is in use");
+        return NULL;
+    }
+    if (key.scale != 1 && key.scale != 4 && key.scale != 16 && key.scale != 64 && key.scale != 256) {
+        PyErr_SetString(PyExc_ValueError, "scale must be 1, 4, 16, 64 or 256");
+        return NULL;
+    }
+    // Block coordinates of the tile must fit in an int at every scale.
+    long long limit = INT_MAX / 256 / self->tile;
+    if (key.tx < -limit || key.tx >= limit || key.tz < -limit || key.tz >= limit) {
+        PyErr_SetString(PyExc_OverflowError, "Tile coordinates are out of range");
+        return NULL;
+    }
+
+    ArrayObject *ret = Array_zeros('i', sizeof(int), self->tile, self->tile);
+    if (!ret) {
+        return NULL;
+    }
+    int *ids = (int *)ret->data;
+
+    int64_t record = TileCache_find(self, &key);
+    if (record >= 0) {
+        const unsigned char *cells = TileCache_record(self, record);
+        if (!cells) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        for (size_t i = 0; i < (size_t)self->tile * self->tile; i++) {
+            ids[i] = cells[i] == 255 ? -1 : cells[i];
+        }
+        self->hits++;
+        return (PyObject *)ret;
+    }
+
+    if (TileCache_generate(self, &key, ids) < 0 || TileCache_append(self, &key, ids) < 0) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    self->generated++;
+    return (PyObject *)ret;
+}
+
+static PyObject *BiomeTileCache_close(BiomeTileCacheObject *self, PyObject *Py_UNUSED(args)) {
+    if (self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "BiomeTileCache is in use");
+        return NULL;
+    }
+    TileCache_close_file(self);
+    Py_RETURN_NONE;
+}
+
+static Py_ssize_t BiomeTileCache_length(BiomeTileCacheObject *self) {
+    return (Py_ssize_t)self->count;
+}
+
+static PySequenceMethods BiomeTileCache_as_sequence = {
+    .sq_length = (lenfunc) BiomeTileCache_length,
+};
+
+static PyMethodDef BiomeTileCache_methods[] = {
+    {"get", (PyCFunction) BiomeTileCache_get, METH_VARARGS | METH_KEYWORDS, "Returns the biomes of tile (tx, tz) at the given scale and y as an int32 Array of tile rows along z, generating it only if it is not cached"},
+    {"close", (PyCFunction) BiomeTileCache_close, METH_NOARGS, "Unmaps and closes the cache file"},
+    {NULL}  /* Sentinel */
+};
+
+static PyMemberDef BiomeTileCache_members[] = {
+    {"tile", T_INT, offsetof(BiomeTileCacheObject, tile), READONLY, "Width and height of a tile in cells"},
+    {"hits", T_ULONGLONG, offsetof(BiomeTileCacheObject, hits), READONLY, "Tiles served from the cache file"},
+    {"generated", T_ULONGLONG, offsetof(BiomeTileCacheObject, generated), READONLY, "Tiles generated with genBiomes"},
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject BiomeTileCacheType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "pybiomes.BiomeTileCache",
+    .tp_doc = "File-backed cache of biome tiles at scales 1 to 256, keyed by seed, dimension, scale, y and tile",
+    .tp_basicsize = sizeof(BiomeTileCacheObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) BiomeTileCache_init,
+    .tp_dealloc = (destructor) BiomeTileCache_dealloc,
+    .tp_as_sequence = &BiomeTileCache_as_sequence,
+    .tp_methods = BiomeTileCache_methods,
+    .tp_members = BiomeTileCache_members,
+};
@@ -0,0 +1,338 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "external/cubiomes/finders.h"
+#include "external/cubiomes/util.h"
+
+/*
+ * Native biome map rendering for Generator.render_biomes and
+ * render_to_buffer. The map is generated and coloured in stripes of rows on
+ * the thread pool, structure markers are drawn on top, and the image is
+ * written as PPM (with util.c) or as PNG.
+ *
+ * The PNG writer needs no zlib: the image goes into stored (uncompressed)
+ * deflate blocks, so only the crc32 and adler32 checksums are computed.
+ */
+
+#define RENDER_STRIPE 16
+#define RENDER_MAX_STRUCTURES 32
+#define RENDER_MARKER 3     // marker half size in pixels
+
+/*
+ * Fills colors with the cubiomes biome colours, overridden by a dict of
+ * biome id to (r, g, b) if obj is not None. Returns 0, or -1 with an
+ * exception set.
+ */
+static int render_parse_colors(PyObject *obj, unsigned char colors[256][3]) {
+    initBiomeColors(colors);
+    if (!obj || obj == Py_None) {
+        return 0;
+    }
+    if (!PyDict_Check(obj)) {
+        PyErr_SetString(PyExc_TypeError, "colors must be a dict of biome id to (r, g, b)");
+        return -1;
+    }
+
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(obj, &pos, &key, &value)) {
+        long id = PyLong_AsLong(key);
+        if (id == -1 && PyErr_Occurred()) {
+            return -1;
+        }
+        if (id < 0 || id > 255) {
+            PyErr_SetString(PyExc_ValueError, "Biome ids in colors must be between 0 and 255");
+            return -1;
+        }
+        if (!PyTuple_Check(value)) {
+            PyErr_SetString(PyExc_TypeError, "colors values must be (r, g, b) tuples");
+            return -1;
+        }
+        if (!PyArg_ParseTuple(value, "bbb;colors values must be (r, g, b) tuples", &colors[id][0], &colors[id][1], &colors[id][2])) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Reads a sequence of structure types into types, checking that each is
+ * supported by version mc. Returns the count, or -1 with an exception set.
+ */
+static int render_parse_structures(PyObject *obj, int mc, int types[RENDER_MAX_STRUCTURES]) {
+    if (!obj || obj == Py_None) {
+        return 0;
+    }
+
+    PyObject *seq = PySequence_Fast(obj, "structures must be a sequence of structure types");
+    if (!seq) {
+        return -1;
+    }
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if (n > RENDER_MAX_STRUCTURES) {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "At most %d structure types can be drawn", RENDER_MAX_STRUCTURES);
+        return -1;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        long type = PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+        if (type == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+        StructureConfig sc;
+        if (type < 0 || type > INT_MAX || !getStructureConfig((int)type, mc, &sc)) {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "Structure is not supported by this version");
+            return -1;
+        }
+        types[i] = (int)type;
+    }
+    Py_DECREF(seq);
+    return (int)n;
+}
+
+typedef struct {
+    Range range;                // sy == 1
+    int pixscale;
+    size_t width;               // image width in pixels
+    unsigned char (*colors)[3];
+    unsigned char *pixels;
+    int **caches;               // one stripe of biome ids per thread
+    int failed;
+} BiomeRender;
+
+static void render_worker(void *arg, int tid, uint64_t lo, uint64_t hi) {
+    BiomeRender *rd = (BiomeRender *)arg;
+    Generator *g = pool_generator(tid);
+    int *ids = rd->caches[tid];
+
+    for (uint64_t row = lo; row < hi; row += RENDER_STRIPE) {
+        Range r = rd->range;
+        r.z += (int)row;
+        r.sz = hi - row < RENDER_STRIPE ? (int)(hi - row) : RENDER_STRIPE;
+        if (genBiomes(g, ids, r) != 0) {
+            rd->failed = 1;
+            continue;
+        }
+        unsigned char *out = rd->pixels + row * rd->pixscale * rd->width * 3;
+        biomesToImage(out, rd->colors, ids, r.sx, r.sz, rd->pixscale, 0);
+    }
+}
+
+// Draws a white square with a black border centred on pixel (px, pz).
+static void render_marker(unsigned char *pixels, size_t width, size_t height, long px, long pz) {
+    for (long dz = -RENDER_MARKER; dz <= RENDER_MARKER; dz++) {
+        for (long dx = -RENDER_MARKER; dx <= RENDER_MARKER; dx++) {
+            long x = px + dx, z = pz + dz;
+            if (x < 0 || z < 0 || (size_t)x >= width || (size_t)z >= height) {
+                continue;
+            }
+            int edge = dx == -RENDER_MARKER || dx == RENDER_MARKER || dz == -RENDER_MARKER || dz == RENDER_MARKER;
+            memset(pixels + ((size_t)z * width + x) * 3, edge ? 0 : 255, 3);
+        }
+    }
+}
+
+/*
+ * Marks the viable positions of each structure type inside the rendered
+ * area. g is the seeded generator the map was rendered from.
+ */
+static void render_structures(const BiomeRender *rd, Generator *g, const int *types, int count, size_t height) {
+    const Range *r = &rd->range;
+    long x0 = (long)r->x * r->scale, z0 = (long)r->z * r->scale;
+    long x1 = x0 + (long)r->sx * r->scale, z1 = z0 + (long)r->sz * r->scale;
+
+    for (int i = 0; i < count; i++) {
+        StructureConfig sc;
+        if (!getStructureConfig(types[i], g->mc, &sc) || sc.dim != g->dim) {
+            continue;
+        }
+        long size = (long)sc.regionSize * 16;
+        long rx0 = x0 >= 0 ? x0 / size : (x0 + 1) / size - 1;
+        long rz0 = z0 >= 0 ? z0 / size : (z0 + 1) / size - 1;
+
+        for (long rz = rz0; rz * size < z1; rz++) {
+            for (long rx = rx0; rx * size < x1; rx++) {
+                Pos p;
+                if (!getStructurePos(types[i], g->mc, g->seed, (int)rx, (int)rz, &p)) {
+                    continue;
+                }
+                if (p.x < x0 || p.x >= x1 || p.z < z0 || p.z >= z1) {
+                    continue;
+                }
+                if (!isViableStructurePos(types[i], g, p.x, p.z, 0)) {
+                    continue;
+                }
+                long px = (p.x - x0) * rd->pixscale / r->scale;
+                long pz = (p.z - z0) * rd->pixscale / r->scale;
+                render_marker(rd->pixels, rd->width, height, px, pz);
+            }
+        }
+    }
+}
+
+static uint32_t crc32_table[256];
+
+// Fills the crc32 table. Called once from module init.
+static void crc32_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        crc32_table[n] = c;
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc = crc32_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static uint32_t adler32_update(uint32_t adler, const unsigned char *data, size_t len) {
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+    while (len) {
+        // 5552 bytes is the most that cannot overflow b before the modulo.
+        size_t n = len < 5552 ? len : 5552;
+        len -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+typedef struct {
+    FILE *f;
+    uint32_t crc;   // of the current chunk
+    int err;
+} PngOut;
+
+static void png_put(PngOut *o, const void *data, size_t len) {
+    o->crc = crc32_update(o->crc, (const unsigned char *)data, len);
+    if (fwrite(data, 1, len, o->f) != len) {
+        o->err = 1;
+    }
+}
+
+static void png_put_u32(PngOut *o, uint32_t v) {
+    unsigned char b[4] = {v >> 24, v >> 16, v >> 8, v};
+    png_put(o, b, 4);
+}
+
+static void png_chunk_begin(PngOut *o, const char *type, uint32_t len) {
+    png_put_u32(o, len);
+    o->crc = 0xffffffffu;
+    png_put(o, type, 4);
+}
+
+static void png_chunk_end(PngOut *o) {
+    png_put_u32(o, o->crc ^ 0xffffffffu);
+}
+
+typedef struct {
+    PngOut *out;
+    unsigned char block[65535];
+    size_t fill;
+    uint64_t done, total;   // bytes of scanline data written and overall
+    uint32_t adler;
+} PngDeflate;
+
+static void png_flush_block(PngDeflate *z) {
+    z->done += z->fill;
+    unsigned char header[5] = {z->done == z->total, z->fill & 0xff, z->fill >> 8, ~z->fill & 0xff, (~z->fill >> 8) & 0xff};
+    png_put(z->out, header, 5);
+    png_put(z->out, z->block, z->fill);
+    z->fill = 0;
+}
+
+static void png_feed(PngDeflate *z, const unsigned char *data, size_t len) {
+    z->adler = adler32_update(z->adler, data, len);
+    while (len) {
+        size_t n = sizeof(z->block) - z->fill;
+        n = n < len ? n : len;
+        memcpy(z->block + z->fill, data, n);
+        z->fill += n;
+        data += n;
+        len -= n;
+        if (z->fill == sizeof(z->block) || z->done + z->fill == z->total) {
+            png_flush_block(z);
+        }
+    }
+}
+
+/*
+ * Writes an 8-bit RGB image as a PNG made of one IDAT chunk of stored
+ * deflate blocks. Returns 0, or -1 with errno set by the failed file
+ * operation, or with errno 0 for an image too large for one chunk.
+ */
+static int save_png(const char *path, const unsigned char *pixels, size_t width, size_t height) {
+    uint64_t row = 1 + (uint64_t)width * 3;     // filter byte and pixels
+    uint64_t total = row * height;
+    uint64_t blocks = (total + 65534) / 65535;
+    uint64_t zlen = 2 + total + 5 * blocks + 4;
+    if (zlen > 0x7fffffff || width > 0x7fffffff || height > 0x7fffffff) {
+        errno = 0;
+        return -1;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return -1;
+    }
+    PngDeflate *z = (PngDeflate *)malloc(sizeof(PngDeflate));
+    if (!z) {
+        fclose(f);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    PngOut o = {f, 0, 0};
+    static const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    png_put(&o, signature, 8);
+
+    png_chunk_begin(&o, "IHDR", 13);
+    png_put_u32(&o, (uint32_t)width);
+    png_put_u32(&o, (uint32_t)height);
+    // 8 bits per sample, RGB, deflate, adaptive filtering, no interlace
+    static const unsigned char ihdr[5] = {8, 2, 0, 0, 0};
+    png_put(&o, ihdr, 5);
+    png_chunk_end(&o);
+
+    png_chunk_begin(&o, "IDAT", (uint32_t)zlen);
+    static const unsigned char zlib_header[2] = {0x78, 0x01};
+    png_put(&o, zlib_header, 2);
+    z->out = &o;
+    z->fill = 0;
+    z->done = 0;
+    z->total = total;
+    z->adler = 1;
+    static const unsigned char filter_none = 0;
+    for (size_t j = 0; j < height; j++) {
+        png_feed(z, &filter_none, 1);
+        png_feed(z, pixels + j * width * 3, width * 3);
+    }
+    png_put_u32(&o, z->adler);
+    png_chunk_end(&o);
+    free(z);
+
+    png_chunk_begin(&o, "IEND", 0);
+    png_chunk_end(&o);
+
+    int err = o.err | ferror(f);
+    err |= fclose(f) != 0;
+    return err ? -1 : 0;
+}
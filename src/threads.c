@@ -0,0 +1,605 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "pythread.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "external/cubiomes/generator.h"
+
+/*
+ * Native parallel-for over a range of seeds, used by the bulk search
+ * methods. Every job runs on one thread pool shared by the whole module.
+ * Workers are started with the portable PyThread API the first time they
+ * are needed and then park on a lock between jobs. They never touch the
+ * interpreter, so jobs run with the GIL released.
+ *
+ * A job splits its range evenly between the threads taking part. Each
+ * thread takes chunks from the front of its own share, and once that is
+ * empty it steals the back half of the largest share left. Ranges with very
+ * uneven per-seed cost (early-exit filters) then keep every thread busy
+ * without all threads contending on one counter.
+ *
+ * Jobs are serialised by the pool lock. From pool_begin to pool_end the
+ * caller owns the pool, including the per-thread Generators set up by
+ * pool_generators, which are kept between jobs and only set up again when
+ * the version or flags change.
+ *
+ * Work that should overlap with the caller, such as prefetching the next
+ * tile of an iterator, goes instead to one background thread next to the
+ * pool, which runs submitted tasks in order. A task still queued when its
+ * owner waits for it is run by the owner.
+ *
+ * A forked child has none of the worker threads and may inherit locks held
+ * by threads that no longer exist, so it starts over with new locks and no
+ * workers. The Generators are plain memory and are kept, but set up again.
+ * Background tasks that had not finished are queued again, so the child
+ * runs them itself when it waits for them.
+ */
+
+#define MAX_THREADS 256
+
+typedef void (*range_worker)(void *ctx, int tid, uint64_t lo, uint64_t hi);
+
+// The part of the current job's range still owned by one thread.
+typedef struct {
+    PyThread_type_lock lock;
+    uint64_t next;
+    uint64_t end;
+} WorkShare;
+
+typedef struct {
+    PyThread_type_lock wake;  // released to hand the worker the current job
+    WorkShare share;
+    Generator *generator;     // reused between jobs
+    int mc;
+    uint32_t flags;
+} PoolSlot;
+
+typedef struct {
+    PyThread_type_lock lock;  // held by the caller from pool_begin to pool_end
+    PyThread_type_lock done;  // held until the last thread of a job returns
+    PyThread_type_lock count; // guards running
+    int running;
+    int started;              // slots 1..started have a worker thread
+    int size;                 // threads used for threads=0, 0 for one per CPU
+    int threads;              // threads in the current job
+    uint64_t chunk;
+    range_worker fn;
+    void *ctx;
+    PoolSlot slots[MAX_THREADS];
+} ThreadPool;
+
+static ThreadPool pool;
+
+typedef struct BackgroundTask {
+    void (*fn)(void *ctx);
+    void *ctx;
+    PyThread_type_lock done;  // held from submission until fn returns
+    struct BackgroundTask *next;
+} BackgroundTask;
+
+typedef struct {
+    PyThread_type_lock lock;  // guards the queue and running
+    PyThread_type_lock wake;  // released to wake a sleeping worker
+    BackgroundTask *head, *tail;
+    BackgroundTask *running;
+    int started;
+    int sleeping;
+} BackgroundQueue;
+
+static BackgroundQueue background;
+
+static int pool_alloc_locks(void) {
+    pool.lock = PyThread_allocate_lock();
+    pool.done = PyThread_allocate_lock();
+    pool.count = PyThread_allocate_lock();
+    pool.slots[0].share.lock = PyThread_allocate_lock();
+    return pool.lock && pool.done && pool.count && pool.slots[0].share.lock ? 0 : -1;
+}
+
+#ifndef _WIN32
+/*
+ * The background lock is held across fork so the child sees the queue
+ * between updates. Its holders never wait on anything else.
+ */
+static void pool_before_fork(void) {
+    PyThread_acquire_lock(background.lock, WAIT_LOCK);
+}
+
+static void pool_after_fork_parent(void) {
+    PyThread_release_lock(background.lock);
+}
+
+/*
+ * Resets the pool in a forked child. The inherited locks may be held by
+ * threads that were not copied, so they are abandoned rather than freed,
+ * and workers are started again by the next pool_begin.
+ */
+static void pool_after_fork(void) {
+    for (int i = 0; i < MAX_THREADS; i++) {
+        pool.slots[i].wake = NULL;
+        pool.slots[i].share.lock = NULL;
+        // A job may have been setting it up when the parent forked.
+        pool.slots[i].mc = -1;
+    }
+    pool.started = 0;
+    pool.running = 0;
+    if (pool_alloc_locks() < 0) {
+        // A fork handler cannot report errors, and a stale lock would hang.
+        abort();
+    }
+
+    // The task the worker was running goes back to the front of the queue.
+    if (background.running) {
+        background.running->next = background.head;
+        background.head = background.running;
+        if (!background.tail) {
+            background.tail = background.running;
+        }
+        background.running = NULL;
+    }
+    for (BackgroundTask *task = background.head; task; task = task->next) {
+        task->done = PyThread_allocate_lock();
+        if (!task->done) {
+            abort();
+        }
+        PyThread_acquire_lock(task->done, WAIT_LOCK);
+    }
+    background.started = 0;
+    background.sleeping = 0;
+    background.wake = PyThread_allocate_lock();
+    if (!background.wake) {
+        abort();
+    }
+    PyThread_acquire_lock(background.wake, WAIT_LOCK);
+    PyThread_release_lock(background.lock);
+}
+#endif
+
+// Allocates the pool locks. Called once from module init, with the GIL.
+static int pool_init(void) {
+    if (pool.lock) {
+        return 0;
+    }
+    background.lock = PyThread_allocate_lock();
+    background.wake = PyThread_allocate_lock();
+    if (pool_alloc_locks() < 0 || !background.lock || !background.wake) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    // Held while the worker sleeps, which it does until the first task.
+    PyThread_acquire_lock(background.wake, WAIT_LOCK);
+#ifndef _WIN32
+    if (pthread_atfork(pool_before_fork, pool_after_fork_parent, pool_after_fork) != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not register the thread pool fork handler");
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/*
+ * Takes the next chunk for thread tid, stealing from the largest share once
+ * its own is empty. Returns 0 when no work is left anywhere. Work being
+ * moved by a thief is invisible for a moment, but the thief processes it,
+ * so the job still completes.
+ */
+static int pool_take(int tid, uint64_t *lo, uint64_t *hi) {
+    WorkShare *own = &pool.slots[tid].share;
+
+    for (;;) {
+        PyThread_acquire_lock(own->lock, WAIT_LOCK);
+        if (own->next < own->end) {
+            *lo = own->next;
+            *hi = own->end - *lo > pool.chunk ? *lo + pool.chunk : own->end;
+            own->next = *hi;
+            PyThread_release_lock(own->lock);
+            return 1;
+        }
+        PyThread_release_lock(own->lock);
+
+        int victim = -1;
+        uint64_t most = 0;
+        for (int i = 0; i < pool.threads; i++) {
+            WorkShare *s = &pool.slots[i].share;
+            PyThread_acquire_lock(s->lock, WAIT_LOCK);
+            uint64_t left = s->end - s->next;
+            PyThread_release_lock(s->lock);
+            if (i != tid && left > most) {
+                victim = i;
+                most = left;
+            }
+        }
+        if (victim < 0) {
+            return 0;
+        }
+
+        WorkShare *s = &pool.slots[victim].share;
+        uint64_t from, to;
+        PyThread_acquire_lock(s->lock, WAIT_LOCK);
+        uint64_t left = s->end - s->next;
+        // Small shares are taken whole, larger ones split in half.
+        from = left > pool.chunk ? s->next + left / 2 : s->next;
+        to = s->end;
+        s->end = from;
+        PyThread_release_lock(s->lock);
+
+        PyThread_acquire_lock(own->lock, WAIT_LOCK);
+        own->next = from;
+        own->end = to;
+        PyThread_release_lock(own->lock);
+    }
+}
+
+static void pool_run_share(int tid) {
+    uint64_t lo, hi;
+    while (pool_take(tid, &lo, &hi)) {
+        pool.fn(pool.ctx, tid, lo, hi);
+    }
+
+    PyThread_acquire_lock(pool.count, WAIT_LOCK);
+    if (--pool.running == 0) {
+        PyThread_release_lock(pool.done);
+    }
+    PyThread_release_lock(pool.count);
+}
+
+static void pool_worker(PoolSlot *slot) {
+    int tid = (int)(slot - pool.slots);
+    for (;;) {
+        PyThread_acquire_lock(slot->wake, WAIT_LOCK);
+        pool_run_share(tid);
+    }
+}
+
+// Starts the worker thread for slot i. Returns 0, or -1 on failure.
+static int pool_start_worker(int i) {
+    PoolSlot *slot = &pool.slots[i];
+    if (!slot->share.lock) {
+        slot->share.lock = PyThread_allocate_lock();
+        if (!slot->share.lock) {
+            return -1;
+        }
+    }
+    if (!slot->wake) {
+        slot->wake = PyThread_allocate_lock();
+        if (!slot->wake) {
+            return -1;
+        }
+        // Held while idle; the worker blocks on it until the next job.
+        PyThread_acquire_lock(slot->wake, WAIT_LOCK);
+    }
+    if (PyThread_start_new_thread((void (*)(void *))pool_worker, slot) == PYTHREAD_INVALID_THREAD_ID) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Takes the pool, starting workers so that `threads` threads (the caller
+ * included) can take part in its jobs. Must be called without the GIL and
+ * paired with pool_end. Returns the number of threads available, which is
+ * lower than requested if a thread could not be started.
+ */
+static int pool_begin(int threads) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    PyThread_acquire_lock(pool.lock, WAIT_LOCK);
+    while (pool.started + 1 < threads && pool_start_worker(pool.started + 1) == 0) {
+        pool.started++;
+    }
+    return threads < pool.started + 1 ? threads : pool.started + 1;
+}
+
+static void pool_end(void) {
+    PyThread_release_lock(pool.lock);
+}
+
+/*
+ * Sets up the Generators of the first `threads` slots for mc and flags,
+ * keeping those already set up for them. Returns 0, or -1 if one could not
+ * be allocated. Between pool_begin and pool_end only.
+ */
+static int pool_generators(int threads, int mc, uint32_t flags) {
+    for (int i = 0; i < threads; i++) {
+        PoolSlot *slot = &pool.slots[i];
+        if (!slot->generator) {
+            slot->generator = (Generator *)malloc(sizeof(Generator));
+            if (!slot->generator) {
+                return -1;
+            }
+        } else if (slot->mc == mc && slot->flags == flags) {
+            continue;
+        }
+        setupGenerator(slot->generator, mc, flags);
+        slot->mc = mc;
+        slot->flags = flags;
+    }
+    return 0;
+}
+
+// The Generator of thread tid, for range workers of a job that called pool_generators.
+static inline Generator *pool_generator(int tid) {
+    return pool.slots[tid].generator;
+}
+
+/*
+ * Calls fn on chunks of [lo, hi) from `threads` threads of the pool, the
+ * calling thread included, and returns once the whole range is processed.
+ * tid is in [0, threads) so workers can keep per-thread state. Between
+ * pool_begin and pool_end only, with threads no more than it returned.
+ */
+static void pool_run(uint64_t lo, uint64_t hi, uint64_t chunk, int threads, range_worker fn, void *ctx) {
+    if (lo > hi) {
+        lo = hi;
+    }
+
+    uint64_t q = (hi - lo) / threads, r = (hi - lo) % threads;
+    for (int i = 0; i < threads; i++) {
+        WorkShare *s = &pool.slots[i].share;
+        s->next = lo + q * i + (uint64_t)(i < (int)r ? i : (int)r);
+        s->end = s->next + q + (i < (int)r);
+    }
+    pool.threads = threads;
+    pool.chunk = chunk ? chunk : 1;
+    pool.fn = fn;
+    pool.ctx = ctx;
+    pool.running = threads;
+
+    PyThread_acquire_lock(pool.done, WAIT_LOCK);
+    for (int i = 1; i < threads; i++) {
+        PyThread_release_lock(pool.slots[i].wake);
+    }
+    pool_run_share(0);
+
+    PyThread_acquire_lock(pool.done, WAIT_LOCK);
+    PyThread_release_lock(pool.done);
+    // The last thread still holds pool.count while signalling done.
+    PyThread_acquire_lock(pool.count, WAIT_LOCK);
+    PyThread_release_lock(pool.count);
+}
+
+/*
+ * Runs one job on the pool for callers without per-thread Generators. Must
+ * be called without the GIL. Returns the number of threads used.
+ */
+static int parallel_range(uint64_t lo, uint64_t hi, uint64_t chunk, int threads, range_worker fn, void *ctx) {
+    threads = pool_begin(threads);
+    pool_run(lo, hi, chunk, threads, fn, ctx);
+    pool_end();
+    return threads;
+}
+
+static void background_worker(void *Py_UNUSED(arg)) {
+    for (;;) {
+        PyThread_acquire_lock(background.lock, WAIT_LOCK);
+        BackgroundTask *task = background.head;
+        if (task) {
+            background.head = task->next;
+            if (!background.head) {
+                background.tail = NULL;
+            }
+            background.running = task;
+        } else {
+            background.sleeping = 1;
+        }
+        PyThread_release_lock(background.lock);
+
+        if (!task) {
+            PyThread_acquire_lock(background.wake, WAIT_LOCK);
+            continue;
+        }
+        task->fn(task->ctx);
+
+        // Released under the queue lock, so a fork sees either a running
+        // task or a finished one.
+        PyThread_acquire_lock(background.lock, WAIT_LOCK);
+        background.running = NULL;
+        PyThread_release_lock(task->done);
+        PyThread_release_lock(background.lock);
+    }
+}
+
+// Allocates the lock of a task. Returns 0, or -1 on failure.
+static int background_task_init(BackgroundTask *task) {
+    task->done = PyThread_allocate_lock();
+    return task->done ? 0 : -1;
+}
+
+// Frees a task that is not queued.
+static void background_task_free(BackgroundTask *task) {
+    if (task->done) {
+        PyThread_free_lock(task->done);
+        task->done = NULL;
+    }
+}
+
+/*
+ * Queues fn(ctx) on the background thread, starting it if needed. If it
+ * cannot be started the task stays queued and runs in background_wait. fn
+ * must not touch the interpreter and may be run again in a forked child.
+ */
+static void background_submit(BackgroundTask *task, void (*fn)(void *), void *ctx) {
+    task->fn = fn;
+    task->ctx = ctx;
+    task->next = NULL;
+    PyThread_acquire_lock(task->done, WAIT_LOCK);
+
+    PyThread_acquire_lock(background.lock, WAIT_LOCK);
+    if (background.tail) {
+        background.tail->next = task;
+    } else {
+        background.head = task;
+    }
+    background.tail = task;
+    if (!background.started) {
+        background.started = PyThread_start_new_thread(background_worker, NULL) != PYTHREAD_INVALID_THREAD_ID;
+    } else if (background.sleeping) {
+        background.sleeping = 0;
+        PyThread_release_lock(background.wake);
+    }
+    PyThread_release_lock(background.lock);
+}
+
+/*
+ * Waits for a submitted task to finish. A task still queued is taken off
+ * the queue and run by the caller, or dropped if cancel is set. Must be
+ * called without the GIL.
+ */
+static void background_wait(BackgroundTask *task, int cancel) {
+    PyThread_acquire_lock(background.lock, WAIT_LOCK);
+    BackgroundTask **link = &background.head, *prev = NULL;
+    while (*link && *link != task) {
+        prev = *link;
+        link = &prev->next;
+    }
+    int queued = *link == task;
+    if (queued) {
+        *link = task->next;
+        if (background.tail == task) {
+            background.tail = prev;
+        }
+    }
+    PyThread_release_lock(background.lock);
+
+    if (!queued) {
+        PyThread_acquire_lock(task->done, WAIT_LOCK);
+    } else if (!cancel) {
+        task->fn(task->ctx);
+    }
+    PyThread_release_lock(task->done);
+}
+
+static int cpu_count(void) {
+    int count = 1;
+    PyObject *os = PyImport_ImportModule("os");
+    if (os) {
+        PyObject *cpus = PyObject_CallMethod(os, "cpu_count", NULL);
+        if (cpus && PyLong_Check(cpus)) {
+            count = (int)PyLong_AsLong(cpus);
+        }
+        Py_XDECREF(cpus);
+        Py_DECREF(os);
+    }
+    PyErr_Clear();
+
+    if (count < 1) {
+        count = 1;
+    }
+    return count < MAX_THREADS ? count : MAX_THREADS;
+}
+
+// Resolves a requested thread count, where 0 means the pool default.
+static int resolve_thread_count(int threads) {
+    if (threads > 0) {
+        return threads < MAX_THREADS ? threads : MAX_THREADS;
+    }
+    return pool.size ? pool.size : cpu_count();
+}
+
+static PyObject *set_num_threads(PyObject *self, PyObject *args) {
+    int threads;
+
+    if (!PyArg_ParseTuple(args, "i", &threads)) {
+        return NULL;
+    }
+    if (threads < 0 || threads > MAX_THREADS) {
+        PyErr_Format(PyExc_ValueError, "Thread count must be between 0 and %d", MAX_THREADS);
+        return NULL;
+    }
+    pool.size = threads;
+    Py_RETURN_NONE;
+}
+
+static PyObject *get_num_threads(PyObject *self, PyObject *Py_UNUSED(args)) {
+    return PyLong_FromLong(resolve_thread_count(0));
+}
+
+/*
+ * Growable array of fixed-size rows, used by workers to collect results
+ * without the GIL. Each thread appends to its own buffer.
+ */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    size_t rowsize;
+    int failed;
+} ResultBuf;
+
+static void resultbuf_init(ResultBuf *rb, size_t rowsize) {
+    rb->data = NULL;
+    rb->len = 0;
+    rb->cap = 0;
+    rb->rowsize = rowsize;
+    rb->failed = 0;
+}
+
+static void resultbuf_push(ResultBuf *rb, const void *row) {
+    if (rb->len == rb->cap) {
+        size_t cap = rb->cap ? rb->cap * 2 : 256;
+        char *data = (char *)realloc(rb->data, cap * rb->rowsize);
+        if (!data) {
+            rb->failed = 1;
+            return;
+        }
+        rb->data = data;
+        rb->cap = cap;
+    }
+    memcpy(rb->data + rb->len * rb->rowsize, row, rb->rowsize);
+    rb->len++;
+}
+
+static void resultbuf_free(ResultBuf *rb) {
+    free(rb->data);
+    resultbuf_init(rb, rb->rowsize);
+}
+
+/*
+ * Concatenates the per-thread buffers into one malloc'd block, freeing them.
+ * Returns NULL and sets *failed if any buffer or the merge ran out of memory.
+ */
+static void *resultbuf_merge(ResultBuf *bufs, int count, size_t *len, int *failed) {
+    size_t total = 0;
+    *failed = 0;
+    for (int i = 0; i < count; i++) {
+        total += bufs[i].len;
+        *failed |= bufs[i].failed;
+    }
+
+    char *data = NULL;
+    if (!*failed) {
+        data = (char *)malloc(total ? total * bufs[0].rowsize : 1);
+        if (!data) {
+            *failed = 1;
+        }
+    }
+
+    size_t off = 0;
+    for (int i = 0; i < count; i++) {
+        if (data && bufs[i].len) {
+            memcpy(data + off, bufs[i].data, bufs[i].len * bufs[i].rowsize);
+            off += bufs[i].len * bufs[i].rowsize;
+        }
+        resultbuf_free(&bufs[i]);
+    }
+
+    *len = data ? total : 0;
+    return data;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
@@ -1,5 +1,10 @@
+import array
+import multiprocessing
+import sys
+
 import pytest
-from pybiomes import Finder, Generator, Pos
+from pybiomes import Finder, Generator, Pos, StrongholdIterator
+from pybiomes.dimensions import DIM_OVERWORLD
 from pybiomes.biomes import plains
 from pybiomes.structures import Village
 from pybiomes.versions import MC_1_21_WD
@@ -59,6 +64,25 @@ def test_init_first_stronghold(finder):
     assert sh['dist'] == 166.02303278628128
     assert sh['rnds'] == 197462054985395
 
+def test_stronghold_iterator(finder):
+    seed = 1234567890
+    generator = Generator(MC_1_21_WD, 0)
+    generator.apply_seed(seed, DIM_OVERWORLD)
+
+    # The native iterator follows the same path as the dict round-trip.
+    _, sh = finder.init_first_stronghold(seed)
+    expected = []
+    for _ in range(5):
+        _, sh = finder.next_stronghold(sh, generator)
+        expected.append((sh['pos'].x, sh['pos'].z))
+
+    positions = [(p.x, p.z) for p in StrongholdIterator(generator, count=5)]
+    assert positions == expected
+
+    strongholds = finder.all_strongholds(generator, count=5)
+    assert strongholds.shape == (5, 2)
+    assert strongholds.tolist() == expected
+
 def test_get_spawn(finder):
     seed = 1234567890
     generator = Generator(MC_1_21_WD, seed)
@@ -68,6 +92,23 @@ def test_get_spawn(finder):
     assert spawn_pos.x == 8
     assert spawn_pos.z == 8
 
+def test_get_spawns(finder):
+    seeds = array.array('q', [0, 1234567890, -42, 2**40 + 7])
+    generator = Generator(MC_1_21_WD, 0)
+
+    exact, estimated = [], []
+    for seed in seeds:
+        generator.apply_seed(seed, DIM_OVERWORLD)
+        spawn = finder.get_spawn(generator)
+        exact.append((spawn.x, spawn.z))
+        spawn = finder.estimate_spawn(generator)
+        estimated.append((spawn.x, spawn.z))
+
+    # The batch matches per-seed calls from any number of threads.
+    for threads in (1, 3):
+        assert finder.get_spawns(generator, seeds, threads=threads).tolist() == exact
+    assert finder.get_spawns(generator, seeds, estimate=True).tolist() == estimated
+
 def test_next_stronghold(finder):
     sh = {
         'pos': Pos(x=0, z=0),
@@ -132,3 +173,54 @@ def test_get_variant(finder):
     invalid_biome_id = 999
     variant_none = finder.get_variant(struct_type, seed, block_x, block_z, invalid_biome_id)
     assert variant_none is None
+
+def test_scan_structure_seeds(finder):
+    # The native scan agrees with calling get_structure_pos per seed.
+    box = (0, 0, 255, 255)
+    expected = []
+    for seed in range(20000):
+        pos = finder.get_structure_pos(Village, seed, 0, 0)
+        if pos and box[0] <= pos.x <= box[2] and box[1] <= pos.z <= box[3]:
+            expected.append(seed)
+
+    for threads in (1, 4):
+        seeds = finder.scan_structure_seeds(Village, 0, 0, 0, 20000, box=box, threads=threads)
+        assert memoryview(seeds).format == 'Q'
+        assert seeds.tolist() == expected
+
+    with pytest.raises(ValueError):
+        finder.scan_structure_seeds(Village, 0, 0, 10, 5)
+
+def scan_villages(threads):
+    finder = Finder(version=MC_1_21_WD)
+    return finder.scan_structure_seeds(Village, 0, 0, 0, 5000, box=(0, 0, 255, 255), threads=threads).tolist()
+
+@pytest.mark.skipif(sys.platform == 'win32', reason='needs fork')
+def test_scan_after_fork():
+    # A child forked after the pool started runs jobs on its own workers.
+    expected = scan_villages(4)
+    with multiprocessing.get_context('fork').Pool(2) as pool:
+        result = pool.map_async(scan_villages, [4, 4])
+        assert result.get(timeout=20) == [expected, expected]
+
+def test_get_structure_positions(finder):
+    seed = 1234567890
+    expected = []
+    for rz in range(-3, 4):
+        for rx in range(-4, 5):
+            pos = finder.get_structure_pos(Village, seed, rx, rz)
+            if pos:
+                expected.append((pos.x, pos.z))
+
+    positions = finder.get_structure_positions(Village, seed, -4, -3, 4, 3, threads=2)
+    assert memoryview(positions).format == 'i'
+    assert positions.tolist() == expected
+
+    # With a generator only the viable attempts are kept.
+    generator = Generator(MC_1_21_WD, 0)
+    generator.apply_seed(seed, DIM_OVERWORLD)
+    viable = [p for p in expected if generator.is_viable_structure_pos(Village, p[0], p[1], 0)]
+    assert finder.get_structure_positions(Village, seed, -4, -3, 4, 3, generator=generator).tolist() == viable
+
+    with pytest.raises(ValueError):
+        finder.get_structure_positions(Village, seed, 4, 0, -4, 0)
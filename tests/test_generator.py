@@ -1,7 +1,17 @@
+import array
+import copy
+import os
+import pickle
+import signal
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+
 import pytest
 from pybiomes import Generator, Pos
 from pybiomes.biomes import plains, river
-from pybiomes.dimensions import DIM_OVERWORLD
+from pybiomes.climate import NP_CONTINENTALNESS, NP_TEMPERATURE, NP_WEIRDNESS
+from pybiomes.dimensions import DIM_NETHER, DIM_OVERWORLD
 from pybiomes.structures import Village
 from pybiomes.versions import MC_1_21_WD
 
@@ -16,6 +26,66 @@ def test_apply_seed(generator):
     generator.apply_seed(seed_to_test, DIM_OVERWORLD)
     assert True
 
+def test_lazy_apply_seed(generator):
+    seed = 1234567890
+    eager = Generator(version=MC_1_21_WD, flags=0)
+    eager.apply_seed(seed, DIM_OVERWORLD)
+    generator.apply_seed(seed, DIM_OVERWORLD, lazy=True)
+
+    # Lazily initialised parameters sample the same noise as a full seed.
+    for param in (NP_WEIRDNESS, NP_TEMPERATURE, NP_CONTINENTALNESS):
+        for x, z in ((0, 0), (72, 496), (-300, 1234)):
+            assert generator.sample_climate(param, x, z) == eager.sample_climate(param, x, z)
+
+    # Anything else completes the seed first.
+    assert generator.get_biome_at(4, 72, 64, 496) == eager.get_biome_at(4, 72, 64, 496)
+
+    with pytest.raises(ValueError):
+        generator.sample_climate(99, 0, 0)
+
+def test_copy_and_pickle(generator):
+    generator.apply_seed(1234567890, DIM_OVERWORLD)
+    points = [(NP_TEMPERATURE, 72, 496), (NP_WEIRDNESS, -300, 1234)]
+    expected = [generator.sample_climate(p, x, z) for p, x, z in points]
+    biome = generator.get_biome_at(4, 72, 64, 496)
+
+    clones = [generator.copy(), copy.deepcopy(generator), pickle.loads(pickle.dumps(generator))]
+
+    # Reseeding the original must not disturb the cloned noise.
+    generator.apply_seed(42, DIM_OVERWORLD)
+    for clone in clones:
+        assert [clone.sample_climate(p, x, z) for p, x, z in points] == expected
+        assert clone.get_biome_at(4, 72, 64, 496) == biome
+
+    # A lazy seed is carried over and still completes on demand.
+    generator.apply_seed(1234567890, DIM_OVERWORLD, lazy=True)
+    assert generator.__reduce__()[2] == (1234567890, DIM_OVERWORLD, True)
+    for clone in (generator.copy(), pickle.loads(pickle.dumps(generator))):
+        assert clone.sample_climate(*points[0]) == expected[0]
+        assert clone.get_biome_at(4, 72, 64, 496) == biome
+
+    # An unseeded generator round-trips too.
+    fresh = pickle.loads(pickle.dumps(Generator(MC_1_21_WD, 0)))
+    assert fresh.__reduce__()[1] == (MC_1_21_WD, 0)
+
+def test_climate_arrays(generator):
+    generator.apply_seed(1234567890, DIM_OVERWORLD)
+    xs = array.array('i', [0, 72, -300, 5])
+    zs = array.array('i', [0, 496, 1234, -5])
+
+    values = generator.sample_climate_points(NP_CONTINENTALNESS, xs, zs)
+    assert values.format == 'd'
+    assert values.tolist() == [generator.sample_climate(NP_CONTINENTALNESS, x, z) for x, z in zip(xs, zs)]
+
+    # Range cells at scale 16 are four 1:4 cells apart.
+    grid = generator.sample_climate_range(NP_WEIRDNESS, -2, 3, 5, 4, scale=16)
+    assert grid.shape == (4, 5)
+    assert grid[1][2] == generator.sample_climate(NP_WEIRDNESS, 0, 16)
+
+    lo, hi = min(values), max(values)
+    assert generator.climate_within([(NP_CONTINENTALNESS, lo, hi)], xs, zs)
+    assert not generator.climate_within([(NP_CONTINENTALNESS, lo, hi), (NP_TEMPERATURE, 2.0, 3.0)], xs, zs)
+
 def test_get_biome_at(generator):
     # This test checks if the generator returns the correct biome ID for a specific coordinate.
     seed = 1234567890
@@ -27,6 +97,24 @@ def test_get_biome_at(generator):
     assert isinstance(biome_id, int)
     assert biome_id == plains
 
+def test_get_biomes_at(generator):
+    # The batched lookup matches get_biome_at point by point, in input order.
+    seed = 1234567890
+    generator.apply_seed(seed, DIM_OVERWORLD)
+
+    points = [(x * 37 % 500, 64, z * 53 % 500) for x in range(20) for z in range(20)]
+    points += points[:10]  # repeated points
+    xs = array.array('i', [p[0] for p in points])
+    ys = array.array('i', [p[1] for p in points])
+    zs = array.array('i', [p[2] for p in points])
+
+    ids = generator.get_biomes_at(4, xs, ys, zs)
+    assert memoryview(ids).format == 'i'
+    assert ids.tolist() == [generator.get_biome_at(4, *p) for p in points]
+
+    with pytest.raises(ValueError):
+        generator.get_biomes_at(4, xs, ys, zs[:5])
+
 def test_gen_biomes(generator):
     # This test verifies the bulk biome generation functionality.
     seed = 1234567890
@@ -48,7 +136,72 @@ def test_gen_biomes(generator):
     assert len(biomes) == 16 * 1 * 16 # sx * sy * sz
     assert biomes[0] == 21
     assert biomes[255] == 45
+
+def test_gen_biomes_buffer(generator):
+    # The result of gen_biomes exposes its cache through the buffer protocol.
+    seed = 1234567890
+    generator.apply_seed(seed, DIM_OVERWORLD)
+
+    biomes = generator.gen_biomes(0, 60, 0, 8, 2, 4, 4)
+    view = memoryview(biomes)
+
+    assert biomes.shape == (8, 2, 4)
+    assert view.shape == (8, 2, 4)
+    assert view.format == 'i'
+    assert view.itemsize == 4
+    assert view.readonly
+
+    flat = biomes.tolist()
+    assert len(flat) == 8 * 2 * 4
+    # The cache is ordered [y][z][x], the view is indexed [x][y][z].
+    assert view[3, 1, 2] == flat[1 * 8 * 4 + 2 * 8 + 3]
+    assert biomes.get(3, 1, 2) == flat[1 * 8 * 4 + 2 * 8 + 3]
+    assert biomes.range.sx == 8 and biomes.range.scale == 4
+
+    # Contiguous requests are refused unless the view really is contiguous.
+    import ctypes
+    PyBUF_STRIDES, PyBUF_FORMAT = 0x18, 0x4
+    contiguous = {'C': PyBUF_STRIDES | 0x20, 'F': PyBUF_STRIDES | 0x40, 'A': PyBUF_STRIDES | 0x80}
+    get_buffer = ctypes.pythonapi.PyObject_GetBuffer
+    get_buffer.argtypes = (ctypes.py_object, ctypes.c_void_p, ctypes.c_int)
+    release = ctypes.pythonapi.PyBuffer_Release
+    release.argtypes = (ctypes.c_void_p,)
+
+    def request(obj, flags):
+        view = ctypes.create_string_buffer(256)
+        try:
+            get_buffer(obj, view, flags | PyBUF_FORMAT)
+        except BufferError:
+            return False
+        release(view)
+        return True
+
+    assert not any(request(biomes, flags) for flags in contiguous.values())
+    column = generator.gen_biomes(0, 60, 0, 8, 1, 1, 4)
+    assert all(request(column, flags) for flags in contiguous.values())
+    # With sy == 1 the [z][x] cache is the Fortran order of (sx, 1, sz).
+    plane = generator.gen_biomes(0, 60, 0, 8, 1, 4, 4)
+    assert [request(plane, flags) for flags in contiguous.values()] == [False, True, True]
+
+def test_gen_biomes_into(generator):
+    # Writing into a caller-provided buffer matches gen_biomes.
+    seed = 1234567890
+    generator.apply_seed(seed, DIM_OVERWORLD)
+
+    expected = generator.gen_biomes(0, 60, 0, 16, 1, 16, 16).tolist()
+
+    size = generator.get_min_cache_size(16, 16, 1, 16)
+    assert size >= 16 * 16
+    out = array.array('i', [0]) * size
+    generator.gen_biomes_into(out, 0, 60, 0, 16, 1, 16, 16)
+    assert out.tolist()[:16 * 16] == expected
+
+    with pytest.raises(ValueError):
+        generator.gen_biomes_into(array.array('i', [0]), 0, 60, 0, 16, 1, 16, 16)
+    with pytest.raises(TypeError):
+        generator.gen_biomes_into(array.array('d', [0]) * size, 0, 60, 0, 16, 1, 16, 16)
     
+
 def test_is_viable_structure_pos(generator):
     # This test checks if a given location is a viable spot for a structure.
     seed = 1234567890
@@ -82,13 +235,190 @@ def test_map_approx_height(generator):
     generator.apply_seed(seed, DIM_OVERWORLD)
     # Get height and biome IDs for a single block.
     x, z, w, h = 288, 1984, 1, 1
-    y_list, ids_list = generator.map_approx_height(surface_noise, x>>2, z>>2, w, h)
+    heights, ids = generator.map_approx_height(surface_noise, x>>2, z>>2, w, h)
     
-    assert isinstance(y_list, list)
-    assert isinstance(ids_list, list)
-    assert len(y_list) == w * h
-    assert len(ids_list) == w * h
+    assert memoryview(heights).format == 'f'
+    assert memoryview(ids).format == 'i'
+    assert memoryview(heights).shape == (h, w)
+    assert memoryview(ids).shape == (h, w)
     
     # The height value will be a float, so we need to allow for some tolerance.
-    assert pytest.approx(y_list[0], 0.01) == 77.12
-    assert ids_list[0] == plains
+    assert pytest.approx(heights[0][0], 0.01) == 77.12
+    assert ids[0][0] == plains
+
+def test_height_tiles(generator):
+    # Tiles and output buffers give the same map as one call.
+    from array import array
+    from pybiomes import SurfaceNoise
+
+    seed = 1234567890
+    surface_noise = SurfaceNoise()
+    surface_noise.init_surface_noise(DIM_OVERWORLD, seed)
+    generator.apply_seed(seed, DIM_OVERWORLD)
+
+    x, z, w, h = -20, 30, 37, 23
+    heights, ids = generator.map_approx_height(surface_noise, x, z, w, h)
+    expected = {}
+    for j, (hrow, irow) in enumerate(zip(heights, ids)):
+        for i in range(w):
+            expected[x + i, z + j] = (hrow[i], irow[i])
+
+    out_heights, out_ids = array('f', bytes(4 * w * h)), array('i', bytes(4 * w * h))
+    ret = generator.map_approx_height(surface_noise, x, z, w, h, heights=out_heights, ids=out_ids)
+    assert ret[0] is out_heights and ret[1] is out_ids
+    assert list(zip(out_heights, out_ids)) == [expected[x + i, z + j] for j in range(h) for i in range(w)]
+    with pytest.raises(ValueError):
+        generator.map_approx_height(surface_noise, x, z, w, h, heights=array('f', [0.0]))
+
+    # Reseeding after creating the iterator does not change its map.
+    tiles = generator.iter_height_tiles(surface_noise, x, z, w, h, tile=16)
+    generator.apply_seed(seed + 1, DIM_OVERWORLD)
+    seen = {}
+    for tx, tz, theights, tids in tiles:
+        assert memoryview(theights).shape[0] <= 16 and memoryview(theights).shape[1] <= 16
+        for j, (hrow, irow) in enumerate(zip(theights, tids)):
+            for i in range(len(hrow)):
+                seen[tx + i, tz + j] = (hrow[i], irow[i])
+    assert seen == expected
+
+    # Dropping an iterator with a tile in flight is safe.
+    next(iter(generator.iter_height_tiles(surface_noise, 0, 0, 64, 64, tile=8)))
+
+    # Stepping past the last tile does not overflow at the edge of the int range.
+    edge = 2**31 - 1 - 20
+    tiles = generator.iter_height_tiles(surface_noise, edge, edge, 20, 20, tile=16)
+    assert [(tx, tz) for tx, tz, _, _ in tiles] == [(edge, edge), (edge + 16, edge), (edge, edge + 16), (edge + 16, edge + 16)]
+
+@pytest.mark.skipif(sys.platform == 'win32', reason='needs fork')
+def test_height_tiles_after_fork(generator):
+    # A child forked while a tile is being prefetched maps it itself.
+    from pybiomes import SurfaceNoise
+
+    surface_noise = SurfaceNoise()
+    surface_noise.init_surface_noise(DIM_OVERWORLD, 42)
+    generator.apply_seed(42, DIM_OVERWORLD)
+    expected = [(tx, tz, th.tolist()) for tx, tz, th, _ in generator.iter_height_tiles(surface_noise, 0, 0, 256, 128, tile=128)]
+
+    tiles = generator.iter_height_tiles(surface_noise, 0, 0, 256, 128, tile=128)
+    pid = os.fork()
+    if pid == 0:
+        ok = [(tx, tz, th.tolist()) for tx, tz, th, _ in tiles] == expected
+        os._exit(0 if ok else 1)
+    assert [(tx, tz, th.tolist()) for tx, tz, th, _ in tiles] == expected
+
+    deadline = time.monotonic() + 20
+    while True:
+        done, status = os.waitpid(pid, os.WNOHANG)
+        if done:
+            break
+        if time.monotonic() > deadline:
+            os.kill(pid, signal.SIGKILL)
+            os.waitpid(pid, 0)
+            pytest.fail('forked child hung waiting for its tile')
+        time.sleep(0.05)
+    assert os.waitstatus_to_exitcode(status) == 0
+
+def test_noise_cache(generator):
+    # Cached noise states give the same results as initialising them again.
+    import pybiomes
+    from pybiomes import SurfaceNoise
+
+    seed = 1234567890
+    budget = pybiomes.noise_cache_info()['budget']
+    try:
+        pybiomes.clear_noise_cache()
+        for _ in range(2):
+            SurfaceNoise().init_surface_noise(DIM_OVERWORLD, seed)
+        info = pybiomes.noise_cache_info()
+        assert (info['hits'], info['misses'], info['entries']) == (1, 1, 1)
+
+        surface_noise = SurfaceNoise()
+        surface_noise.init_surface_noise(DIM_OVERWORLD, seed)
+        generator.apply_seed(seed, DIM_OVERWORLD)
+        with_sn = generator.map_approx_height(surface_noise, -8, 8, 12, 10)
+        without_sn = generator.map_approx_height(-8, 8, 12, 10)
+        assert [a.tolist() for a in without_sn] == [a.tolist() for a in with_sn]
+        # Only an Overworld seed has surface noise to cache.
+        entries = pybiomes.noise_cache_info()['entries']
+        with pytest.raises(ValueError):
+            Generator(version=MC_1_21_WD, flags=0).map_approx_height(-8, 8, 12, 10)
+        nether = Generator(version=MC_1_21_WD, flags=0)
+        nether.apply_seed(seed, DIM_NETHER)
+        with pytest.raises(ValueError):
+            nether.map_approx_height(-8, 8, 12, 10)
+        assert pybiomes.noise_cache_info()['entries'] == entries
+
+        expected = [generator.get_biome_at(4, x, 16, 0) for x in range(0, 256, 16)]
+        cached = Generator(version=MC_1_21_WD, flags=0)
+        for s in (seed, seed + 1, seed):
+            cached.apply_seed(s, DIM_OVERWORLD, cache=True)
+        assert [cached.get_biome_at(4, x, 16, 0) for x in range(0, 256, 16)] == expected
+        with pytest.raises(ValueError):
+            cached.apply_seed(seed, DIM_OVERWORLD, lazy=True, cache=True)
+
+        # A small budget evicts the least recently used states.
+        pybiomes.set_noise_cache_size(2 * pybiomes.noise_cache_info()['bytes'] // 3)
+        info = pybiomes.noise_cache_info()
+        assert info['evictions'] > 0 and info['bytes'] <= info['budget']
+
+        pybiomes.set_noise_cache_size(0)
+        SurfaceNoise().init_surface_noise(DIM_OVERWORLD, seed)
+        assert pybiomes.noise_cache_info()['entries'] == 0
+    finally:
+        pybiomes.set_noise_cache_size(budget)
+        pybiomes.clear_noise_cache()
+
+def test_threaded_generators():
+    # Generators used from several threads give the same results as serially.
+    def biomes_for(seed):
+        generator = Generator(version=MC_1_21_WD, flags=0)
+        generator.apply_seed(seed, DIM_OVERWORLD)
+        return [generator.get_biome_at(4, x, 64, 0) for x in range(0, 64, 8)]
+
+    seeds = list(range(32))
+    expected = [biomes_for(seed) for seed in seeds]
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        assert list(pool.map(biomes_for, seeds)) == expected
+
+def test_expand_structure_seed(generator):
+    # The native expansion agrees with checking every upper16 from Python.
+    lower48 = 1234567890
+    checks = [('viable', Village, 288, 1984), ('biome', 4, 72, 64, 496, plains)]
+
+    expected = []
+    for upper16 in range(0x10000):
+        seed = (upper16 << 48) | lower48
+        generator.apply_seed(seed, DIM_OVERWORLD)
+        if (generator.is_viable_structure_pos(Village, 288, 1984, 0)
+                and generator.get_biome_at(4, 72, 64, 496) == plains):
+            expected.append(seed)
+
+    seeds = generator.expand_structure_seed(lower48, checks, threads=4)
+    assert seeds.tolist() == expected
+
+    with pytest.raises(ValueError):
+        generator.expand_structure_seed(lower48, [('cave', 0, 0)])
+
+def test_sample_seeds(generator):
+    # The seed-by-point matrix matches applying each seed from Python.
+    seeds = array.array('Q', [0, 1, 1234567890, 2**63 + 5, 42])
+    points = [(0, 64, 0), (72, 64, 496), (-100, 64, 30)]
+
+    expected = []
+    for seed in seeds:
+        generator.apply_seed(seed, DIM_OVERWORLD)
+        expected.append(tuple(generator.get_biome_at(4, *p) for p in points))
+
+    matrix = generator.sample_seeds(seeds, DIM_OVERWORLD, points, 4, threads=2)
+    assert matrix.shape == (5, 3)
+    assert matrix.tolist() == expected
+
+    # Mask mode reports which seeds match every point.
+    target = list(expected[2])
+    mask = generator.sample_seeds(seeds, DIM_OVERWORLD, points, 4, expected=target)
+    assert memoryview(mask).format == 'B'
+    assert mask.tolist() == [int(list(row) == target) for row in expected]
+
+    # Biome ids outside an int are refused instead of wrapping.
+    with pytest.raises(OverflowError):
+        generator.sample_seeds(seeds, DIM_OVERWORLD, points, 4, expected=[2**32 + target[0]] + target[1:])
@@ -0,0 +1,60 @@
+from array import array
+
+import pytest
+from pybiomes import DoublePerlinNoise, OctaveNoise, PerlinNoise
+
+SEED = 1234567890
+
+def make_noises():
+    perlin = PerlinNoise()
+    perlin.init(SEED)
+    octave = OctaveNoise()
+    octave.init(SEED, -6, 4)
+    double = DoublePerlinNoise()
+    double.init(SEED, -4, 3, xoroshiro=True, amplitudes=[1.0, 0.5, 1.0])
+    return perlin, octave, double
+
+@pytest.mark.parametrize("noise", make_noises())
+def test_sample_grid(noise):
+    # The grid is ordered y, z, x and matches single samples exactly.
+    nx, ny, nz, step = 5, 3, 4, 0.75
+    grid = noise.sample_grid(1.5, -2.0, 7.25, nx, ny, nz, step)
+    assert memoryview(grid).shape == (ny * nz, nx)
+
+    values = memoryview(grid).cast('B').cast('d').tolist()
+    expected = [noise.sample(1.5 + i * step, -2.0 + j * step, 7.25 + k * step)
+                for j in range(ny) for k in range(nz) for i in range(nx)]
+    assert values == expected
+
+    with pytest.raises(ValueError):
+        noise.sample_grid(0, 0, 0, 0, 1, 1)
+
+@pytest.mark.parametrize("noise", make_noises())
+def test_sample_points(noise):
+    xs = array('d', [i * 0.37 for i in range(100)])
+    ys = array('d', [i * -1.5 for i in range(100)])
+    zs = array('d', [i * 2.1 for i in range(100)])
+    values = noise.sample_points(xs, ys, zs, threads=3).tolist()
+    assert values == [noise.sample(x, y, z) for x, y, z in zip(xs, ys, zs)]
+
+    with pytest.raises(ValueError):
+        noise.sample_points(xs, ys, zs[:10])
+    with pytest.raises(TypeError):
+        noise.sample_points(array('f', xs), ys, zs)
+
+def test_noise_init():
+    # Reseeding replaces the octaves, and the seed decides the noise.
+    a, b = OctaveNoise(), OctaveNoise()
+    a.init(SEED, -6, 4)
+    b.init(SEED + 1, -3, 2)
+    assert b.oct_count == 2
+    b.init(SEED, -6, 4)
+    assert b.oct_count == 4
+    assert a.sample(1.5, 2.5, 3.5) == b.sample(1.5, 2.5, 3.5)
+
+    with pytest.raises(ValueError):
+        a.init(SEED, 0, 2)
+    with pytest.raises(ValueError):
+        a.init(SEED, -4, 2, amplitudes=[1.0, 1.0])
+    with pytest.raises(ValueError):
+        DoublePerlinNoise().init(SEED, -4, 2, xoroshiro=True, amplitudes=[1.0])
@@ -0,0 +1,133 @@
+import threading
+
+import pytest
+import pybiomes
+from pybiomes import Finder, Generator, Pipeline
+from pybiomes.biomes import plains
+from pybiomes.climate import NP_TEMPERATURE
+from pybiomes.structures import Village
+from pybiomes.versions import MC_1_21_WD
+
+@pytest.fixture
+def finder():
+    return Finder(version=MC_1_21_WD)
+
+def test_lower48_stages(finder):
+    # Structure and variant stages agree with the equivalent Python loop.
+    pipeline = Pipeline(MC_1_21_WD)
+    pipeline.add_variant(Village, 0, 0, plains, rotation=1)
+    pipeline.add_structure(Village, 0, 0, box=(0, 0, 255, 255))
+
+    expected = []
+    for seed in range(5000):
+        pos = finder.get_structure_pos(Village, seed, 0, 0)
+        if not pos or not (0 <= pos.x <= 255 and 0 <= pos.z <= 255):
+            continue
+        variant = finder.get_variant(Village, seed, pos.x, pos.z, plains)
+        if variant and variant['rotation'] == 1:
+            expected.append(seed)
+
+    assert pipeline.run(0, 5000, threads=2).tolist() == expected
+
+    # The cheaper structure stage runs first and only its survivors reach
+    # the variant stage.
+    stats = pipeline.stats
+    assert [s['stage'] for s in stats] == ['structure', 'variant']
+    assert stats[0]['evaluated'] == 5000
+    assert stats[1]['evaluated'] == stats[0]['passed']
+    assert stats[1]['passed'] == len(expected)
+
+    # Out of range values are refused, including above 1 for the flags.
+    with pytest.raises(ValueError):
+        pipeline.add_variant(Village, 0, 0, plains, rotation=256)
+    with pytest.raises(ValueError):
+        pipeline.add_variant(Village, 0, 0, plains, giant=2)
+
+def test_variant_flags(finder):
+    # One-bit flags are matched on their own, not with the flags beside them.
+    for abandoned, giant in ((1, 1), (1, 0), (0, 1)):
+        pipeline = Pipeline(MC_1_21_WD)
+        pipeline.add_variant(Village, 0, 0, plains, abandoned=abandoned, giant=giant)
+        expected = []
+        for seed in range(5000):
+            pos = finder.get_structure_pos(Village, seed, 0, 0)
+            variant = pos and finder.get_variant(Village, seed, pos.x, pos.z, plains)
+            if variant and (variant['abandoned'], variant['giant']) == (abandoned, giant):
+                expected.append(seed)
+        assert pipeline.run(0, 5000, threads=2).tolist() == expected
+
+    pipeline.reset_stats()
+    assert all(s['evaluated'] == 0 for s in pipeline.stats)
+
+def test_world_stages(finder):
+    # World stages match expanding the structure seed with the same checks.
+    lower48 = 1234567890
+    pos = finder.get_structure_pos(Village, lower48, 0, 0)
+
+    pipeline = Pipeline(MC_1_21_WD)
+    pipeline.add_structure(Village, 0, 0, box=(pos.x, pos.z, pos.x, pos.z))
+    pipeline.add_biome(4, pos.x >> 2, 64, pos.z >> 2, plains)
+    pipeline.add_viable(Village, pos.x, pos.z)
+
+    generator = Generator(MC_1_21_WD, 0)
+    expected = generator.expand_structure_seed(lower48, [
+        ('viable', Village, pos.x, pos.z),
+        ('biome', 4, pos.x >> 2, 64, pos.z >> 2, plains),
+    ])
+    assert pipeline.run(lower48, lower48 + 1).tolist() == expected.tolist()
+
+    stats = {s['stage']: s for s in pipeline.stats}
+    assert stats['structure']['passed'] == 1
+    assert stats['biome']['evaluated'] + stats['viable']['evaluated'] >= 0x10000
+
+def test_climate_stages(finder):
+    # Climate stages skip applySeed for the seeds they reject but keep the
+    # same results as expanding with climate checks.
+    lower48 = 1234567890
+    pos = finder.get_structure_pos(Village, lower48, 0, 0)
+
+    pipeline = Pipeline(MC_1_21_WD)
+    pipeline.add_structure(Village, 0, 0, box=(pos.x, pos.z, pos.x, pos.z))
+    pipeline.add_viable(Village, pos.x, pos.z)
+    pipeline.add_climate(NP_TEMPERATURE, pos.x >> 2, pos.z >> 2, -0.2, 0.2)
+
+    generator = Generator(MC_1_21_WD, 0)
+    expected = generator.expand_structure_seed(lower48, [
+        ('climate', NP_TEMPERATURE, pos.x >> 2, pos.z >> 2, -0.2, 0.2),
+        ('viable', Village, pos.x, pos.z),
+    ])
+    assert pipeline.run(lower48, lower48 + 1).tolist() == expected.tolist()
+    assert [s['stage'] for s in pipeline.stats] == ['structure', 'climate', 'viable']
+
+def test_thread_pool():
+    # The shared pool gives the same seeds and stats for any thread count,
+    # including jobs submitted from several Python threads at once.
+    pipeline = Pipeline(MC_1_21_WD)
+    pipeline.add_structure(Village, 0, 0, box=(0, 0, 127, 127))
+    expected = pipeline.run(0, 20000, threads=1).tolist()
+
+    default = pybiomes.get_num_threads()
+    try:
+        pybiomes.set_num_threads(5)
+        assert pybiomes.get_num_threads() == 5
+        for threads in (0, 3, 8):
+            pipeline.reset_stats()
+            assert pipeline.run(0, 20000, threads=threads).tolist() == expected
+            assert pipeline.stats[0]['evaluated'] == 20000
+    finally:
+        pybiomes.set_num_threads(0)
+    assert pybiomes.get_num_threads() == default
+
+    with pytest.raises(ValueError):
+        pybiomes.set_num_threads(-1)
+
+    finder = Finder(MC_1_21_WD)
+    results = [None] * 4
+    def scan(i):
+        results[i] = finder.scan_structure_seeds(Village, 0, 0, 0, 20000, box=(0, 0, 127, 127), threads=3).tolist()
+    workers = [threading.Thread(target=scan, args=(i,)) for i in range(4)]
+    for t in workers:
+        t.start()
+    for t in workers:
+        t.join()
+    assert all(r == expected for r in results)
@@ -0,0 +1,43 @@
+import pytest
+from pybiomes import Finder, QuadSearch
+from pybiomes.structures import Monument, Swamp_Hut
+from pybiomes.versions import MC_1_21_WD
+
+N = 1 << 21
+
+def test_quad_bases():
+    finder = Finder(MC_1_21_WD)
+    hits = list(QuadSearch(MC_1_21_WD, Swamp_Hut, 0, N, threads=2, chunk=1 << 18))
+
+    for base, positions in hits:
+        regions = [(0, 0), (1, 0), (0, 1), (1, 1)]
+        for (rx, rz), pos in zip(regions, positions):
+            expected = finder.get_structure_pos(Swamp_Hut, base, rx, rz)
+            assert (pos.x, pos.z) == (expected.x, expected.z)
+
+    # Moving a base shifts the quad to the requested regions.
+    if hits:
+        base, positions = hits[0]
+        moved = QuadSearch.move(base, 3, -2)
+        pos = finder.get_structure_pos(Swamp_Hut, moved, 3, -2)
+        assert (pos.x - 3 * 32 * 16, pos.z + 2 * 32 * 16) == (positions[0].x, positions[0].z)
+
+def test_resume():
+    everything = list(QuadSearch(MC_1_21_WD, Swamp_Hut, 0, N, chunk=1 << 16))
+
+    search = QuadSearch(MC_1_21_WD, Swamp_Hut, 0, N, chunk=1 << 16)
+    first = [next(search) for _ in range(min(2, len(everything)))]
+    resumed = list(QuadSearch(MC_1_21_WD, Swamp_Hut, search.position, N, chunk=1 << 16))
+
+    # Resuming may repeat hits of a partly consumed chunk but never skips any.
+    assert sorted(set(b for b, _ in first + resumed)) == sorted(b for b, _ in everything)
+    assert search.position <= N
+
+    with pytest.raises(ValueError):
+        QuadSearch(MC_1_21_WD, Swamp_Hut, low_bits='unknown')
+
+def test_low_bits():
+    # The low bit lists only hold for the hut region layout.
+    with pytest.raises(ValueError):
+        QuadSearch(MC_1_21_WD, Monument, low_bits='barely')
+    assert QuadSearch(MC_1_21_WD, Monument, 0, 0, low_bits=None).position == 0
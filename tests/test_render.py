@@ -0,0 +1,75 @@
+import struct
+import zlib
+
+import pytest
+from pybiomes import Generator, Range
+from pybiomes.dimensions import DIM_OVERWORLD
+from pybiomes.structures import Village
+from pybiomes.versions import MC_1_21_WD
+
+SEED = 1234567890
+
+@pytest.fixture
+def generator():
+    generator = Generator(version=MC_1_21_WD, flags=0)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    return generator
+
+def test_render_to_buffer(generator):
+    # Each cell takes the colour of its biome, rows running along z.
+    r = Range(4, -20, 16, 8, 45, 1, 37)
+    biomes = memoryview(generator.gen_biomes(-20, 16, 8, 45, 1, 37, 4))
+    ids = sorted({biomes[x, 0, z] for x in range(45) for z in range(37)})
+    colors = {b: (i, 2 * i, 255 - i) for i, b in enumerate(ids)}
+
+    image = generator.render_to_buffer(r, colors=colors, pixscale=2, threads=3)
+    assert image.shape == (74, 90, 3)
+    rows = image.tolist()
+    for z in range(37):
+        for x in range(45):
+            assert rows[2 * z + 1][2 * x] == colors[biomes[x, 0, z]]
+
+    # Stripes rendered on any number of threads form the same image.
+    assert bytes(generator.render_to_buffer(r, threads=1)) == bytes(generator.render_to_buffer(r, threads=4))
+
+    with pytest.raises(ValueError):
+        generator.render_to_buffer(Range(4, 0, 0, 0, 16, 2, 16))
+    with pytest.raises(ValueError):
+        generator.render_to_buffer(r, colors={256: (0, 0, 0)})
+
+def test_render_structures(generator):
+    r = Range(16, -256, 4, -256, 512, 1, 512)
+    plain = bytes(generator.render_to_buffer(r))
+    marked = generator.render_to_buffer(r, structures=[Village])
+    # Markers only change pixels, never the image size.
+    assert len(bytes(marked)) == len(plain)
+    assert bytes(marked) != plain
+
+def test_render_files(generator, tmp_path):
+    r = Range(4, 0, 16, 0, 70, 1, 30)
+    pixels = bytes(generator.render_to_buffer(r))
+
+    ppm = tmp_path / 'map.ppm'
+    generator.render_biomes(r, str(ppm))
+    data = ppm.read_bytes()
+    assert data.startswith(b'P6') and data.endswith(pixels)
+
+    # The PNG holds valid checksums and the same pixels after unfiltering.
+    png = tmp_path / 'map.png'
+    generator.render_biomes(r, png)
+    data = png.read_bytes()
+    assert data[:8] == b'\x89PNG\r\n\x1a\n'
+    pos, chunks = 8, {}
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        (crc,) = struct.unpack('>I', data[pos + 8 + length:pos + 12 + length])
+        assert crc == zlib.crc32(kind + body)
+        chunks[kind] = body
+        pos += 12 + length
+    assert struct.unpack('>IIBBBBB', chunks[b'IHDR']) == (70, 30, 8, 2, 0, 0, 0)
+    raw = zlib.decompress(chunks[b'IDAT'])
+    assert b''.join(raw[j * 211 + 1:(j + 1) * 211] for j in range(30)) == pixels
+
+    with pytest.raises(ValueError):
+        generator.render_biomes(r, str(png), format='gif')
@@ -0,0 +1,40 @@
+import pytest
+from pybiomes import Rng, Xoroshiro
+
+SEED = 1234567890
+
+def test_rng_bulk():
+    # Bulk draws continue the same stream as single calls.
+    single, bulk = Rng(SEED), Rng(SEED)
+    assert bulk.next_ints(204, 50).tolist() == [single.next_int(204) for _ in range(50)]
+    assert bulk.next_ints(16, 20).tolist() == [single.next_int(16) for _ in range(20)]
+    assert bulk.next_floats(50).tolist() == pytest.approx([single.next_float() for _ in range(50)], abs=0)
+    assert bulk.next_longs(50).tolist() == [single.next_long() for _ in range(50)]
+
+    assert bulk.next_ints(4, 0).tolist() == []
+    with pytest.raises(ValueError):
+        bulk.next_ints(0, 5)
+    with pytest.raises(ValueError):
+        bulk.next_floats(-1)
+
+def test_rng_skip():
+    # skip(n) matches n single steps, and a negative skip undoes it.
+    stepped, skipped = Rng(SEED), Rng(SEED)
+    for _ in range(1000):
+        stepped.next_float()
+    skipped.skip(1000)
+    assert skipped.next_long() == stepped.next_long()
+
+    rng = Rng(SEED)
+    expected = rng.next_ints(1000, 3).tolist()
+    rng.skip(-3)
+    assert rng.next_ints(1000, 3).tolist() == expected
+
+def test_xoroshiro_bulk():
+    single, bulk = Xoroshiro(), Xoroshiro()
+    single.set_seed(SEED)
+    bulk.set_seed(SEED)
+    assert bulk.next_ints(7, 50).tolist() == [single.next_int(7) for _ in range(50)]
+    assert bulk.next_floats(50).tolist() == pytest.approx([single.next_float() for _ in range(50)], abs=0)
+    assert bulk.next_longs(50).tolist() == [single.next_long() for _ in range(50)]
+    assert bulk.next_longs(3).format == 'Q'
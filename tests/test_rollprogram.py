@@ -0,0 +1,51 @@
+import array
+
+import pytest
+from pybiomes import Finder, RollProgram, Rng
+from pybiomes.versions import MC_1_21_1
+
+def python_rolls(finder, seed, cx, cz):
+    rng = Rng(finder.chunk_generate_rnd(seed, cx, cz))
+    underground = rng.next_float() < 0.5
+    giant = rng.next_float() < 0.05
+    var = rng.next_int(10)
+    rng.next_long()
+    rot = rng.next_int(4)
+    return not underground and not giant and 2 <= var <= 5 and rot == 1
+
+def test_roll_program():
+    # The native rolls agree with the same rolls made one at a time.
+    finder = Finder(MC_1_21_1)
+    program = RollProgram([
+        ('float', 0.5, 1.0),
+        ('float', 0.05, 1.0),
+        ('int', 10, 2, 5),
+        ('skip', 2),
+        ('int', 4, 1, 1),
+    ])
+    assert len(program) == 5
+
+    seeds = array.array('Q', range(0, 40000, 7))
+    xs = array.array('i', [(s % 61) - 30 for s in seeds])
+    zs = array.array('i', [(s % 53) - 26 for s in seeds])
+    expected = [i for i, s in enumerate(seeds) if python_rolls(finder, s, xs[i], zs[i])]
+
+    for threads in (1, 3):
+        assert program.run(seeds, xs, zs, threads=threads).tolist() == expected
+
+    # One chunk coordinate can be given for every row.
+    expected = [i for i, s in enumerate(seeds) if python_rolls(finder, s, -25, 3)]
+    assert program.run(seeds, -25, 3).tolist() == expected
+
+def test_roll_program_errors():
+    with pytest.raises(ValueError):
+        RollProgram([('dice', 6)])
+    with pytest.raises(ValueError):
+        RollProgram([('int', 0)])
+    with pytest.raises(TypeError):
+        RollProgram([('int', 10, 2)])
+    program = RollProgram([('bool', True)])
+    with pytest.raises(ValueError):
+        program.run(array.array('Q', [1, 2]), array.array('i', [0]), 0)
+    with pytest.raises(OverflowError):
+        program.run(array.array('Q', [1, 2]), 1 << 32, 0)
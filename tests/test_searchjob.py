@@ -0,0 +1,67 @@
+import pytest
+from pybiomes import Pipeline, SearchJob
+from pybiomes.structures import Village
+from pybiomes.versions import MC_1_21_WD
+
+def make_pipeline():
+    pipeline = Pipeline(MC_1_21_WD)
+    pipeline.add_structure(Village, 0, 0, box=(0, 0, 127, 127))
+    return pipeline
+
+def read_seeds(path):
+    with open(path) as f:
+        return [int(line) for line in f]
+
+def test_resume(tmp_path):
+    checkpoint, results = tmp_path / 'job.ckpt', tmp_path / 'job.txt'
+    expected = make_pipeline().run(0, 50000).tolist()
+
+    job = SearchJob(make_pipeline(), 0, 50000, checkpoint, results, chunk=4096)
+    job.run(max_chunks=3)
+    assert job.next == 3 * 4096 and not job.done
+
+    # A chunk that was written but never checkpointed is dropped on resume.
+    with open(results, 'a') as f:
+        f.write('123\n')
+
+    job = SearchJob(make_pipeline(), 0, 50000, checkpoint, results, chunk=4096)
+    assert job.next == 3 * 4096
+    job.run()
+    assert job.done
+    assert read_seeds(results) == expected
+    assert job.found == len(expected)
+
+    # Finished jobs do nothing more.
+    assert SearchJob(make_pipeline(), 0, 50000, checkpoint, results).run() == 0
+    assert read_seeds(results) == expected
+
+def test_mismatched_checkpoint(tmp_path):
+    checkpoint, results = tmp_path / 'job.ckpt', tmp_path / 'job.txt'
+    SearchJob(make_pipeline(), 0, 10000, checkpoint, results).run(max_chunks=0)
+    SearchJob(make_pipeline(), 0, 10000, checkpoint, results, chunk=1000).run(max_chunks=1)
+
+    with pytest.raises(ValueError):
+        SearchJob(make_pipeline(), 0, 20000, checkpoint, results)
+
+    # Existing results without a checkpoint cannot be resumed.
+    checkpoint.unlink()
+    with pytest.raises(ValueError):
+        SearchJob(make_pipeline(), 0, 10000, checkpoint, results)
+
+def test_short_results(tmp_path):
+    checkpoint, results = tmp_path / 'job.ckpt', tmp_path / 'job.txt'
+    job = SearchJob(make_pipeline(), 0, 50000, checkpoint, results, chunk=4096)
+    job.run(max_chunks=3)
+    assert job.found > 0
+
+    # Results that lost seeds are refused rather than padded back out.
+    data = results.read_bytes()
+    results.write_bytes(data[:-1])
+    with pytest.raises(ValueError):
+        SearchJob(make_pipeline(), 0, 50000, checkpoint, results)
+    assert results.read_bytes() == data[:-1]
+
+    results.unlink()
+    with pytest.raises(ValueError):
+        SearchJob(make_pipeline(), 0, 50000, checkpoint, results)
+    assert not results.exists()
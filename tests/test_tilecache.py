@@ -0,0 +1,69 @@
+import pytest
+from pybiomes import BiomeTileCache, Generator
+from pybiomes.dimensions import DIM_OVERWORLD
+from pybiomes.versions import MC_1_21_WD
+
+SEED = 1234567890
+
+@pytest.fixture
+def generator():
+    return Generator(version=MC_1_21_WD, flags=0)
+
+def test_tile_cache(generator, tmp_path):
+    path = tmp_path / 'tiles.bin'
+    cache = BiomeTileCache(generator, path, tile=32)
+    assert cache.tile == 32 and len(cache) == 0
+
+    # A tile holds the gen_biomes cells it covers, rows running along z.
+    tile = cache.get(SEED, DIM_OVERWORLD, 4, 16, -1, 2)
+    assert tile.shape == (32, 32)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    biomes = memoryview(generator.gen_biomes(-32, 16, 64, 32, 1, 32, 4))
+    rows = tile.tolist()
+    assert all(rows[z][x] == biomes[x, 0, z] for x in range(32) for z in range(32))
+
+    # Repeat requests are served from the file without generating.
+    assert cache.get(SEED, DIM_OVERWORLD, 4, 16, -1, 2).tolist() == rows
+    assert (cache.hits, cache.generated, len(cache)) == (1, 1, 1)
+
+    cache.get(SEED + 1, DIM_OVERWORLD, 4, 16, -1, 2)
+    cache.get(SEED, DIM_OVERWORLD, 1, 64, 0, 0)
+    assert (cache.generated, len(cache)) == (3, 3)
+
+    # Coarse tiles are generated directly, even with the 1:4 tiles under them cached.
+    coarse = cache.get(SEED, DIM_OVERWORLD, 16, 16, 0, 0)
+    generator.apply_seed(SEED, DIM_OVERWORLD)
+    biomes = memoryview(generator.gen_biomes(0, 16, 0, 32, 1, 32, 16))
+    assert coarse.tolist() == [tuple(biomes[x, 0, z] for x in range(32)) for z in range(32)]
+    assert (cache.generated, len(cache)) == (4, 4)
+    cache.close()
+    with pytest.raises(RuntimeError):
+        cache.get(SEED, DIM_OVERWORLD, 4, 16, -1, 2)
+
+    # Reopening reads the index back from the file.
+    cache = BiomeTileCache(generator, path, tile=32)
+    assert len(cache) == 4
+    assert cache.get(SEED, DIM_OVERWORLD, 4, 16, -1, 2).tolist() == rows
+    assert (cache.hits, cache.generated) == (1, 0)
+
+    with pytest.raises(ValueError):
+        cache.get(SEED, DIM_OVERWORLD, 8, 16, 0, 0)
+    with pytest.raises(ValueError):
+        BiomeTileCache(generator, path, tile=64)
+    with pytest.raises(ValueError):
+        BiomeTileCache(generator, path, tile=8)
+
+def test_tile_cache_truncated(generator, tmp_path):
+    # A record cut short is dropped when the file is opened.
+    path = tmp_path / 'tiles.bin'
+    cache = BiomeTileCache(generator, path, tile=16)
+    cache.get(SEED, DIM_OVERWORLD, 4, 16, 0, 0)
+    cache.get(SEED, DIM_OVERWORLD, 4, 16, 1, 0)
+    cache.close()
+    with open(path, 'r+b') as f:
+        f.truncate(path.stat().st_size - 10)
+
+    cache = BiomeTileCache(generator, path, tile=16)
+    assert len(cache) == 1
+    cache.get(SEED, DIM_OVERWORLD, 4, 16, 1, 0)
+    assert (cache.hits, cache.generated) == (0, 1)